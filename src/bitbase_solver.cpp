@@ -0,0 +1,963 @@
+#include <vector>
+#include <string>
+#include <array>
+#include <algorithm>
+#include <string_view>
+#include <utility>
+#include <type_traits>
+#include <bit>
+#include <stdexcept>
+#include <chess.hpp>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "bitbase_solver.h"
+#include "king_tables.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        using Bits = std::uint64_t;
+
+        auto constexpr NUM_BOARD_SQUARES = 64;
+        auto constexpr BITS_PER_SQUARE = 6;
+        auto constexpr MAX_PIECES = 8;
+
+        // Capture information kept per position. For white to move this is the depth to mate of
+        // the quickest winning capture, while for black to move it is the depth to mate a position
+        // could have when every capture leads to a forced win (i.e. the slowest one, plus one).
+        auto constexpr NO_CAPTURE = std::uint8_t{0};
+        auto constexpr CAPTURE_ESCAPES = std::uint8_t{255};
+
+        auto constexpr NOT_FILE_A = ~Bits{0x0101010101010101};
+        auto constexpr NOT_FILE_H = ~Bits{0x8080808080808080};
+        auto constexpr NOT_FILES_AB = ~Bits{0x0303030303030303};
+        auto constexpr NOT_FILES_GH = ~Bits{0xC0C0C0C0C0C0C0C0};
+        auto constexpr ALL_SQUARES = ~Bits{0};
+
+        template <int SHIFT>
+        auto shift(Bits const bits) -> Bits {
+            if constexpr (SHIFT > 0) {
+                return bits << SHIFT;
+            } else {
+                return bits >> -SHIFT;
+            }
+        }
+
+        // Kogge-Stone fill in a single direction, returning every square reached by sliding from
+        // any of the generators through empty squares (including the first blocker in the way)
+        template <int SHIFT, Bits WRAP_MASK>
+        auto slide(Bits generators, Bits empty) -> Bits {
+            empty &= WRAP_MASK;
+            generators |= empty & shift<SHIFT>(generators);
+            empty &= shift<SHIFT>(empty);
+            generators |= empty & shift<2 * SHIFT>(generators);
+            empty &= shift<2 * SHIFT>(empty);
+            generators |= empty & shift<4 * SHIFT>(generators);
+            return shift<SHIFT>(generators) & WRAP_MASK;
+        }
+
+        auto orthogonal_slides(Bits const generators, Bits const empty) -> Bits {
+            return slide<8, ALL_SQUARES>(generators, empty) | slide<-8, ALL_SQUARES>(generators, empty)
+                | slide<1, NOT_FILE_A>(generators, empty) | slide<-1, NOT_FILE_H>(generators, empty);
+        }
+
+        auto diagonal_slides(Bits const generators, Bits const empty) -> Bits {
+            return slide<9, NOT_FILE_A>(generators, empty) | slide<7, NOT_FILE_H>(generators, empty)
+                | slide<-7, NOT_FILE_A>(generators, empty) | slide<-9, NOT_FILE_H>(generators, empty);
+        }
+
+        auto king_steps(Bits const bits) -> Bits {
+            auto const horizontal = ((bits << 1) & NOT_FILE_A) | ((bits >> 1) & NOT_FILE_H);
+            auto const row = bits | horizontal;
+            return horizontal | (row << 8) | (row >> 8);
+        }
+
+        auto knight_jumps(Bits const bits) -> Bits {
+            auto const one_file = ((bits >> 1) & NOT_FILE_H) | ((bits << 1) & NOT_FILE_A);
+            auto const two_files = ((bits >> 2) & NOT_FILES_GH) | ((bits << 2) & NOT_FILES_AB);
+            return (one_file << 16) | (one_file >> 16) | (two_files << 8) | (two_files >> 8);
+        }
+
+        // Plain character comparisons rather than <cctype>, so that they fold away for the pieces of
+        // a specialised solver (see StaticMaterial)
+        auto constexpr is_white_piece(char const piece) -> bool {
+            return 'A' <= piece and piece <= 'Z';
+        }
+
+        auto constexpr piece_type(char const piece) -> char {
+            return is_white_piece(piece) ? static_cast<char>(piece - 'A' + 'a') : piece;
+        }
+
+        // Every square which a piece can move to (or equally, since pawnless moves are symmetric,
+        // move from) to reach one of the given squares, sliding only through empty squares
+        auto moves_of_set(char const piece, Bits const squares, Bits const empty) -> Bits {
+            switch (piece_type(piece)) {
+                case 'k': return king_steps(squares);
+                case 'n': return knight_jumps(squares);
+                case 'b': return diagonal_slides(squares, empty);
+                case 'r': return orthogonal_slides(squares, empty);
+                default: return diagonal_slides(squares, empty) | orthogonal_slides(squares, empty);
+            }
+        }
+
+        // Attacks of a single piece, through chess-library's lookup tables
+        auto attacks_of(char const piece, int const square, Bits const occupied) -> Bits {
+            auto const sq = chess::Square(square);
+            switch (piece_type(piece)) {
+                case 'k': return chess::attacks::king(sq).getBits();
+                case 'n': return chess::attacks::knight(sq).getBits();
+                case 'b': return chess::attacks::bishop(sq, occupied).getBits();
+                case 'r': return chess::attacks::rook(sq, occupied).getBits();
+                default: return chess::attacks::queen(sq, occupied).getBits();
+            }
+        }
+
+        auto scalar_equal_to(std::uint8_t const* const bytes, std::uint8_t const value) -> Bits {
+            auto mask = Bits{0};
+            for (auto square = 0; square < NUM_BOARD_SQUARES; ++square) {
+                mask |= static_cast<Bits>(bytes[square] == value) << square;
+            }
+            return mask;
+        }
+
+        auto scalar_at_least(std::uint8_t const* const bytes, std::uint8_t const value) -> Bits {
+            auto mask = Bits{0};
+            for (auto square = 0; square < NUM_BOARD_SQUARES; ++square) {
+                mask |= static_cast<Bits>(bytes[square] >= value) << square;
+            }
+            return mask;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        __attribute__((target("avx2")))
+        auto avx2_equal_to(std::uint8_t const* const bytes, std::uint8_t const value) -> Bits {
+            auto const target = _mm256_set1_epi8(static_cast<char>(value));
+            auto const low = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bytes));
+            auto const high = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bytes + 32));
+            auto const low_mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, target)));
+            auto const high_mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, target)));
+            return Bits{low_mask} | (Bits{high_mask} << 32);
+        }
+
+        // there is no unsigned byte comparison, but x >= value exactly when max(x, value) == x
+        __attribute__((target("avx2")))
+        auto avx2_at_least(std::uint8_t const* const bytes, std::uint8_t const value) -> Bits {
+            auto const target = _mm256_set1_epi8(static_cast<char>(value));
+            auto const low = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bytes));
+            auto const high = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bytes + 32));
+            auto const low_mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(low, target), low)));
+            auto const high_mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(high, target), high)));
+            return Bits{low_mask} | (Bits{high_mask} << 32);
+        }
+#endif
+
+        // the last kernels supported are the fastest
+        auto const KERNELS = supported_byte_mask_kernels().back();
+
+        // Bitboards of one player's pieces, grouped by how they attack
+        struct SideBitboards {
+            Bits king = 0;
+            Bits knights = 0;
+            Bits diagonal = 0;
+            Bits orthogonal = 0;
+
+            auto add(char const piece, int const square) -> void {
+                auto const bit = Bits{1} << square;
+                switch (piece_type(piece)) {
+                    case 'k': king |= bit; break;
+                    case 'n': knights |= bit; break;
+                    case 'b': diagonal |= bit; break;
+                    case 'r': orthogonal |= bit; break;
+                    default: diagonal |= bit; orthogonal |= bit; break;
+                }
+            }
+        };
+
+        auto is_attacked_by(int const square, SideBitboards const& attackers, Bits const occupied) -> bool {
+            auto const sq = chess::Square(square);
+            return (chess::attacks::knight(sq).getBits() & attackers.knights)
+                or (chess::attacks::king(sq).getBits() & attackers.king)
+                or (chess::attacks::bishop(sq, occupied).getBits() & attackers.diagonal)
+                or (chess::attacks::rook(sq, occupied).getBits() & attackers.orthogonal);
+        }
+
+        // The pieces of the signature being solved, which the solver reads through num_pieces(),
+        // piece(i) and for_each_piece/for_each_fixed_piece (calling f with the index of every
+        // piece, or every piece but the axis piece). RuntimeMaterial reads a signature given at
+        // runtime, while StaticMaterial has its signature as a template parameter, so that every
+        // loop over the pieces is unrolled and every branch on a piece's type or colour is decided
+        // at compile time.
+        class RuntimeMaterial {
+        public:
+            explicit RuntimeMaterial(std::string const& signature)
+                : signature_{PositionIndexer(signature).signature()} {}
+
+            auto signature() const -> std::string const& {
+                return signature_;
+            }
+
+            auto num_pieces() const -> int {
+                return static_cast<int>(signature_.size());
+            }
+
+            auto piece(int const i) const -> char {
+                return signature_[static_cast<std::size_t>(i)];
+            }
+
+            template <typename F>
+            auto for_each_piece(F&& f) const -> void {
+                for (auto i = 0; i < num_pieces(); ++i) {
+                    f(i);
+                }
+            }
+
+            template <typename F>
+            auto for_each_fixed_piece(F&& f) const -> void {
+                for (auto i = 0; i < num_pieces() - 1; ++i) {
+                    f(i);
+                }
+            }
+
+        private:
+            std::string signature_;
+        };
+
+        // A signature usable as a template parameter
+        struct StaticSignature {
+            std::array<char, MAX_PIECES> pieces{};
+            int size = 0;
+
+            auto constexpr view() const -> std::string_view {
+                return std::string_view(pieces.data(), static_cast<std::size_t>(size));
+            }
+        };
+
+        template <StaticSignature SIGNATURE>
+        class StaticMaterial {
+        public:
+            auto signature() const -> std::string {
+                return std::string{SIGNATURE.view()};
+            }
+
+            static auto constexpr num_pieces() -> int {
+                return SIGNATURE.size;
+            }
+
+            static auto constexpr piece(int const i) -> char {
+                return SIGNATURE.pieces[static_cast<std::size_t>(i)];
+            }
+
+            template <typename F>
+            auto for_each_piece(F&& f) const -> void {
+                for_each_below(f, std::make_integer_sequence<int, SIGNATURE.size>{});
+            }
+
+            template <typename F>
+            auto for_each_fixed_piece(F&& f) const -> void {
+                for_each_below(f, std::make_integer_sequence<int, SIGNATURE.size - 1>{});
+            }
+
+        private:
+            template <typename F, int... I>
+            static auto for_each_below(F& f, std::integer_sequence<int, I...>) -> void {
+                (f(std::integral_constant<int, I>{}), ...);
+            }
+        };
+
+        template <typename Material>
+        class BitboardSolver {
+        public:
+            BitboardSolver(
+                Material material,
+                int const max_depth_to_mate,
+                std::map<std::string, DenseTable> const& solved_tables,
+                SolverStrategy const strategy,
+                ShardExchange const* const exchange = nullptr
+            ) : strategy_{strategy},
+                exchange_{exchange},
+                material_{std::move(material)},
+                signature_{material_.signature()},
+                max_depth_to_mate_{max_depth_to_mate},
+                num_configs_{std::uint64_t{2} << (BITS_PER_SQUARE * (num_pieces() - 1))},
+                black_to_move_bit_{std::uint64_t{1} << (BITS_PER_SQUARE * (num_pieces() - 1))},
+                king_pairs_{exchange ? exchange->king_pairs() : KingPairRange{0, NUM_KING_PAIRS}},
+                configs_per_king_pair_{exchange ? (std::uint64_t{1} << (BITS_PER_SQUARE * (num_pieces() - 3))) : 1},
+                num_local_configs_{exchange ? 2 * static_cast<std::uint64_t>(king_pairs_.end - king_pairs_.begin) * configs_per_king_pair_ : num_configs_},
+                legal_(num_configs_, 0),
+                won_(num_configs_, 0),
+                checkmates_(num_local_configs_, 0),
+                candidates_(num_local_configs_, 0),
+                entries_(num_local_configs_ * NUM_BOARD_SQUARES, NOT_A_FORCED_WIN),
+                captures_(num_local_configs_ * NUM_BOARD_SQUARES, NO_CAPTURE),
+                capture_seeds_(static_cast<std::size_t>(max_depth_to_mate + 1)) {
+                if (num_pieces() < 2 or num_pieces() > MAX_PIECES) {
+                    throw std::runtime_error("Cannot solve signature " + signature_ + " with bitboards");
+                }
+                if (exchange_ and num_pieces() < 3) {
+                    throw std::runtime_error("Cannot shard signature " + signature_ + ", as its king pairs are split across configs");
+                }
+                if (exchange_ and strategy_ == SolverStrategy::SWEEP) {
+                    throw std::runtime_error("The sweep strategy cannot be sharded");
+                }
+                if (exchange_) {
+                    outgoing_candidates_.resize(static_cast<std::size_t>(exchange_->num_shards()));
+                }
+
+                // the tables reached by capturing each piece (kings are never captured)
+                for (auto captured = 2; captured < num_pieces(); ++captured) {
+                    auto pieces = std::vector<char>{signature_.begin(), signature_.end()};
+                    pieces.erase(pieces.begin() + captured);
+                    auto const capture_signature = signature_for_pieces(pieces);
+                    auto const table = solved_tables.find(capture_signature);
+                    if (table == solved_tables.end()) {
+                        throw std::runtime_error(capture_signature + " must be solved before " + signature_);
+                    }
+                    capture_tables_[captured] = &table->second;
+                }
+            }
+
+            auto solve() -> DenseTable {
+                find_legal_positions_and_captures();
+                find_checkmates();
+
+                if (strategy_ == SolverStrategy::SWEEP) {
+                    solve_by_sweeping();
+                } else {
+                    solve_by_frontier();
+                }
+
+                // identical pieces were solved as if they were distinct, so only the canonical
+                // ordering of their squares is kept (as in PositionIndexer)
+                for (auto index = std::uint64_t{0}; index < entries_.size(); ++index) {
+                    if (entries_[index] == NOT_A_FORCED_WIN) continue;
+                    auto squares = squares_of(global_config(index / NUM_BOARD_SQUARES));
+                    squares[static_cast<std::size_t>(num_pieces() - 1)] = static_cast<int>(index % NUM_BOARD_SQUARES);
+                    for (auto i = 1; i < num_pieces(); ++i) {
+                        if (material_.piece(i) == material_.piece(i - 1) and squares[static_cast<std::size_t>(i)] < squares[static_cast<std::size_t>(i - 1)]) {
+                            entries_[index] = NOT_A_FORCED_WIN;
+                        }
+                    }
+                }
+
+                return DenseTable{signature_, max_depth_to_mate_, std::move(entries_)};
+            }
+
+        private:
+            // Expands the positions won at each depth into their predecessors, only touching the
+            // configs which are reachable from the last depth's wins
+            auto solve_by_frontier() -> void {
+                auto frontier = std::vector<std::uint64_t>{};
+                for (auto config = black_to_move_bit_; config < num_configs_; ++config) {
+                    if (is_owned(config) and checkmates_[local_config(config)]) {
+                        add_wins(config, checkmates_[local_config(config)], 0);
+                        frontier.push_back(config);
+                    }
+                }
+
+                for (auto depth = 1; depth <= max_depth_to_mate_; ++depth) {
+                    auto const isWhiteTurn = depth % 2 == 1;
+
+                    // the predecessors of last depth's wins, along with positions whose captures
+                    // first become decided at this depth, are the only candidates
+                    auto candidate_configs = std::vector<std::uint64_t>{};
+                    auto last_depth_wins = std::vector<ConfigBits>{};
+                    for (auto const config : frontier) {
+                        auto const positions = won_bits_of_depth(config, depth - 1);
+                        add_unmove_predecessors(config, positions, isWhiteTurn, candidate_configs);
+                        last_depth_wins.push_back(ConfigBits{config, positions});
+                    }
+                    for (auto const index : capture_seeds_[static_cast<std::size_t>(depth)]) {
+                        add_candidates(index / NUM_BOARD_SQUARES, Bits{1} << (index % NUM_BOARD_SQUARES), candidate_configs);
+                    }
+
+                    // the other shards' wins are needed to find black's escapes, and predecessors
+                    // which cross into another shard's king pairs are sent to it
+                    if (exchange_) {
+                        auto const updates = exchange_->exchange(signature_, depth, last_depth_wins, outgoing_candidates_);
+                        for (auto const& [config, bits] : updates.wins) {
+                            won_[config] |= bits;
+                        }
+                        for (auto const& [config, bits] : updates.candidates) {
+                            add_candidates(config, bits, candidate_configs);
+                        }
+                        for (auto& candidates : outgoing_candidates_) {
+                            candidates.clear();
+                        }
+                    }
+
+                    frontier.clear();
+                    for (auto const config : candidate_configs) {
+                        auto wins = candidates_[local_config(config)] & legal_[config] & ~won_[config];
+                        candidates_[local_config(config)] = 0;
+                        if (wins and not isWhiteTurn) {
+                            wins &= ~black_escapes(config, depth);
+                        }
+                        if (wins) {
+                            add_wins(config, wins, depth);
+                            frontier.push_back(config);
+                        }
+                    }
+                }
+            }
+
+            // Scans every config of the player to move at each depth, finding the positions with a
+            // move into the last depth's wins through the byte mask kernels. This does the same work
+            // each depth regardless of how many positions were won, which pays off at the depths
+            // where the frontier is a large part of the table, as every access is sequential.
+            auto solve_by_sweeping() -> void {
+                for (auto config = black_to_move_bit_; config < num_configs_; ++config) {
+                    add_wins(config, checkmates_[local_config(config)], 0);
+                }
+
+                auto last_depth_wins = std::vector<Bits>(num_configs_, 0);
+                for (auto depth = 1; depth <= max_depth_to_mate_; ++depth) {
+                    auto const isWhiteTurn = depth % 2 == 1;
+                    auto const begin = isWhiteTurn ? std::uint64_t{0} : black_to_move_bit_;
+                    auto const successors_begin = black_to_move_bit_ - begin;
+
+                    // every successor has the other player to move
+                    auto const last_entry = static_cast<std::uint8_t>(depth);
+                    for (auto config = successors_begin; config < successors_begin + black_to_move_bit_; ++config) {
+                        last_depth_wins[config] = KERNELS.equal_to(&entries_[config * NUM_BOARD_SQUARES], last_entry);
+                    }
+
+                    for (auto config = begin; config < begin + black_to_move_bit_; ++config) {
+                        auto const undecided = legal_[config] & ~won_[config];
+                        if (undecided == 0) continue;
+
+                        auto wins = undecided & (
+                            moves_into(config, [&last_depth_wins](std::uint64_t const successor) { return last_depth_wins[successor]; })
+                            | KERNELS.equal_to(&captures_[config * NUM_BOARD_SQUARES], static_cast<std::uint8_t>(depth))
+                        );
+                        if (wins and not isWhiteTurn) {
+                            wins &= ~black_escapes(config, depth);
+                        }
+                        add_wins(config, wins, depth);
+                    }
+                }
+            }
+
+            // Configs are only stored for the king pairs this shard owns (all of them unless the
+            // solve is sharded), in the same order as the full table
+            auto is_owned(std::uint64_t const config) const -> bool {
+                if (not exchange_) return true;
+                auto const king_pair = static_cast<int>((config / configs_per_king_pair_) % NUM_KING_PAIRS);
+                return king_pairs_.begin <= king_pair and king_pair < king_pairs_.end;
+            }
+
+            auto local_config(std::uint64_t const config) const -> std::uint64_t {
+                if (not exchange_) return config;
+                auto const is_black_turn = (config & black_to_move_bit_) != 0;
+                auto const king_pair = (config / configs_per_king_pair_) % NUM_KING_PAIRS;
+                auto const num_owned_king_pairs = static_cast<std::uint64_t>(king_pairs_.end - king_pairs_.begin);
+                return ((is_black_turn ? num_owned_king_pairs : 0) + king_pair - static_cast<std::uint64_t>(king_pairs_.begin)) * configs_per_king_pair_
+                    + config % configs_per_king_pair_;
+            }
+
+            auto global_config(std::uint64_t const local) const -> std::uint64_t {
+                if (not exchange_) return local;
+                auto const num_owned_configs = static_cast<std::uint64_t>(king_pairs_.end - king_pairs_.begin) * configs_per_king_pair_;
+                auto const is_black_turn = local >= num_owned_configs;
+                return (is_black_turn ? black_to_move_bit_ : 0)
+                    + static_cast<std::uint64_t>(king_pairs_.begin) * configs_per_king_pair_
+                    + local % num_owned_configs;
+            }
+
+            auto num_pieces() const -> int {
+                return material_.num_pieces();
+            }
+
+            auto axis_piece() const -> char {
+                return material_.piece(num_pieces() - 1);
+            }
+
+            // Squares of the pieces other than the axis piece, in signature order
+            auto squares_of(std::uint64_t const config) const -> std::array<int, MAX_PIECES> {
+                auto squares = std::array<int, MAX_PIECES>{};
+                material_.for_each_fixed_piece([&](auto const i) {
+                    squares[static_cast<std::size_t>(i)] = static_cast<int>((config >> (BITS_PER_SQUARE * (num_pieces() - 2 - i))) & (NUM_BOARD_SQUARES - 1));
+                });
+                return squares;
+            }
+
+            // The config with a piece moved to another square and the other player to move
+            auto config_after_move(std::uint64_t const config, int const piece, int const square) const -> std::uint64_t {
+                auto const offset = BITS_PER_SQUARE * (num_pieces() - 2 - piece);
+                return ((config & ~(std::uint64_t{NUM_BOARD_SQUARES - 1} << offset)) | (static_cast<std::uint64_t>(square) << offset)) ^ black_to_move_bit_;
+            }
+
+            auto occupied_by_others(std::array<int, MAX_PIECES> const& squares) const -> Bits {
+                auto occupied = Bits{0};
+                material_.for_each_fixed_piece([&](auto const i) {
+                    occupied |= Bits{1} << squares[static_cast<std::size_t>(i)];
+                });
+                return occupied;
+            }
+
+            auto others_overlap(std::array<int, MAX_PIECES> const& squares) const -> bool {
+                return std::popcount(occupied_by_others(squares)) != num_pieces() - 1;
+            }
+
+            auto won_bits_of_depth(std::uint64_t const config, int const depth) const -> Bits {
+                return KERNELS.equal_to(&entries_[local_config(config) * NUM_BOARD_SQUARES], static_cast<std::uint8_t>(depth + 1));
+            }
+
+            auto add_candidates(std::uint64_t const config, Bits const bits, std::vector<std::uint64_t>& candidate_configs) -> void {
+                if (bits == 0) return;
+                if (not is_owned(config)) {
+                    auto const king_pair = static_cast<int>((config / configs_per_king_pair_) % NUM_KING_PAIRS);
+                    outgoing_candidates_[static_cast<std::size_t>(exchange_->owner_of_king_pair(king_pair))].push_back(ConfigBits{config, bits});
+                    return;
+                }
+
+                auto& candidates = candidates_[local_config(config)];
+                if (candidates == 0) {
+                    candidate_configs.push_back(config);
+                }
+                candidates |= bits;
+            }
+
+            auto add_wins(std::uint64_t const config, Bits const wins, int const depth) -> void {
+                won_[config] |= wins;
+                auto const first_index = local_config(config) * NUM_BOARD_SQUARES;
+                for (auto remaining = wins; remaining; remaining &= remaining - 1) {
+                    entries_[first_index + static_cast<std::uint64_t>(std::countr_zero(remaining))] = static_cast<std::uint8_t>(depth + 1);
+                }
+            }
+
+            // Finds which positions are legal (the player who just moved is not in check) and
+            // records the outcome of every capture into the already solved smaller signatures.
+            // Legality is needed for the whole table even when sharded, but captures only for the
+            // positions this shard owns.
+            auto find_legal_positions_and_captures() -> void {
+                for (auto config = std::uint64_t{0}; config < num_configs_; ++config) {
+                    auto const squares = squares_of(config);
+                    // with at least 3 pieces both kings are fixed, so touching kings rule out the
+                    // whole config
+                    if (num_pieces() > 2 and not are_legal_king_squares(squares[0], squares[1])) continue;
+                    if (others_overlap(squares)) continue;
+
+                    auto const isWhiteTurn = (config & black_to_move_bit_) == 0;
+                    auto const others = occupied_by_others(squares);
+                    legal_[config] = ~king_attacked_squares(squares, others, isWhiteTurn) & ~others;
+                    if (not is_owned(config)) continue;
+
+                    for (auto remaining = legal_[config]; remaining; remaining &= remaining - 1) {
+                        auto const axis_square = std::countr_zero(remaining);
+                        auto placement = squares;
+                        placement[static_cast<std::size_t>(num_pieces() - 1)] = axis_square;
+                        record_captures(config * NUM_BOARD_SQUARES + static_cast<std::uint64_t>(axis_square), placement, isWhiteTurn);
+                    }
+                }
+            }
+
+            // The axis squares for which the king attacked by the given player is in check, found
+            // for all 64 squares at once. A fixed piece giving check does so wherever the axis piece
+            // is not between it and the king, and the axis piece gives check from the squares it
+            // would attack from the king's square (as pawnless attacks are symmetric).
+            auto king_attacked_squares(std::array<int, MAX_PIECES> const& squares, Bits const others, bool const isWhiteAttacker) const -> Bits {
+                auto const axis_is_attacker = is_white_piece(axis_piece()) == isWhiteAttacker;
+                auto attacked = Bits{0};
+
+                // the attacked king is the axis piece, which cannot block attacks on itself
+                if (piece_type(axis_piece()) == 'k' and not axis_is_attacker) {
+                    material_.for_each_fixed_piece([&](auto const piece) {
+                        auto const attacker = material_.piece(piece);
+                        if (is_white_piece(attacker) == isWhiteAttacker) {
+                            attacked |= attacks_of(attacker, squares[static_cast<std::size_t>(piece)], others);
+                        }
+                    });
+                    return attacked;
+                }
+
+                auto king = 0;
+                material_.for_each_fixed_piece([&](auto const piece) {
+                    auto const defender = material_.piece(piece);
+                    if (piece_type(defender) == 'k' and is_white_piece(defender) != isWhiteAttacker) {
+                        king = squares[static_cast<std::size_t>(piece)];
+                    }
+                });
+
+                material_.for_each_fixed_piece([&](auto const piece) {
+                    auto const attacker = material_.piece(piece);
+                    auto const from = squares[static_cast<std::size_t>(piece)];
+                    if (is_white_piece(attacker) == isWhiteAttacker and (attacks_of(attacker, from, others) & (Bits{1} << king))) {
+                        attacked |= ~SQUARES_BETWEEN[from][king];
+                    }
+                });
+                if (axis_is_attacker) {
+                    attacked |= attacks_of(axis_piece(), king, others);
+                }
+                return attacked;
+            }
+
+            // Whether the player who is not to move has their king out of check, where squares
+            // holds every piece of the signature (including the axis piece), ignoring pieces whose
+            // square is negative (i.e. captured)
+            auto is_legal(std::array<int, MAX_PIECES> const& placement, bool const isWhiteTurn) const -> bool {
+                auto attackers = SideBitboards{};
+                auto occupied = Bits{0};
+                auto defending_king = 0;
+                material_.for_each_piece([&](auto const i) {
+                    auto const square = placement[static_cast<std::size_t>(i)];
+                    if (square < 0) return;
+                    auto const piece = material_.piece(i);
+                    occupied |= Bits{1} << square;
+                    if (is_white_piece(piece) == isWhiteTurn) {
+                        attackers.add(piece, square);
+                    } else if (piece_type(piece) == 'k') {
+                        defending_king = square;
+                    }
+                });
+                return not is_attacked_by(defending_king, attackers, occupied);
+            }
+
+            auto record_captures(std::uint64_t const index, std::array<int, MAX_PIECES> const& placement, bool const isWhiteTurn) -> void {
+                auto occupied = Bits{0};
+                material_.for_each_piece([&](auto const i) {
+                    occupied |= Bits{1} << placement[static_cast<std::size_t>(i)];
+                });
+
+                auto best = NO_CAPTURE;
+                material_.for_each_piece([&](auto const mover) {
+                    auto const mover_piece = material_.piece(mover);
+                    if (is_white_piece(mover_piece) != isWhiteTurn) return;
+                    auto const reachable = attacks_of(mover_piece, placement[static_cast<std::size_t>(mover)], occupied);
+
+                    // kings are never captured
+                    material_.for_each_piece([&](auto const captured) {
+                        if (captured < 2 or is_white_piece(material_.piece(captured)) == isWhiteTurn) return;
+                        auto const target = placement[static_cast<std::size_t>(captured)];
+                        if ((reachable & (Bits{1} << target)) == 0) return;
+
+                        auto after_capture = placement;
+                        after_capture[static_cast<std::size_t>(mover)] = target;
+                        after_capture[static_cast<std::size_t>(captured)] = -1;
+                        // the capture is only a legal move if the mover's own king is left safe
+                        if (not is_legal(after_capture, not isWhiteTurn)) return;
+
+                        auto const depth_to_mate = capture_depth_to_mate(captured, after_capture, not isWhiteTurn);
+                        if (isWhiteTurn) {
+                            if (depth_to_mate >= 0 and (best == NO_CAPTURE or depth_to_mate + 1 < best)) {
+                                best = static_cast<std::uint8_t>(depth_to_mate + 1);
+                            }
+                        } else if (depth_to_mate < 0 or depth_to_mate + 1 > max_depth_to_mate_) {
+                            best = CAPTURE_ESCAPES;
+                        } else if (best != CAPTURE_ESCAPES) {
+                            best = std::max(best, static_cast<std::uint8_t>(depth_to_mate + 1));
+                        }
+                    });
+                });
+
+                captures_[local_config(index / NUM_BOARD_SQUARES) * NUM_BOARD_SQUARES + index % NUM_BOARD_SQUARES] = best;
+                if (best != NO_CAPTURE and best != CAPTURE_ESCAPES and best <= max_depth_to_mate_) {
+                    capture_seeds_[best].push_back(index);
+                }
+            }
+
+            // Looks up a position (with one piece captured) in the smaller signature's table
+            auto capture_depth_to_mate(int const captured, std::array<int, MAX_PIECES> const& placement, bool const isWhiteTurn) const -> int {
+                // removing a piece keeps the rest in signature order, so the smaller signature's
+                // pieces are ours with the captured one skipped
+                auto squares = std::array<int, MAX_PIECES>{};
+                auto pieces = std::array<char, MAX_PIECES>{};
+                material_.for_each_piece([&](auto const i) {
+                    if (i == captured) return;
+                    auto const remaining = static_cast<std::size_t>(i < captured ? static_cast<int>(i) : i - 1);
+                    squares[remaining] = placement[static_cast<std::size_t>(i)];
+                    pieces[remaining] = material_.piece(i);
+                });
+
+                // identical pieces are stored with their squares in ascending order
+                auto const num_remaining = num_pieces() - 1;
+                for (auto i = 1; i < num_remaining; ++i) {
+                    for (auto j = i; j > 0 and pieces[static_cast<std::size_t>(j)] == pieces[static_cast<std::size_t>(j - 1)] and squares[static_cast<std::size_t>(j)] < squares[static_cast<std::size_t>(j - 1)]; --j) {
+                        std::swap(squares[static_cast<std::size_t>(j)], squares[static_cast<std::size_t>(j - 1)]);
+                    }
+                }
+
+                auto index = std::uint64_t{isWhiteTurn ? 0u : 1u};
+                for (auto i = 0; i < num_remaining; ++i) {
+                    index = (index << BITS_PER_SQUARE) | static_cast<std::uint64_t>(squares[static_cast<std::size_t>(i)]);
+                }
+                return depth_to_mate_for_entry(capture_tables_[static_cast<std::size_t>(captured)]->entries[index]);
+            }
+
+            // Black to move positions which are in check and have no legal moves
+            auto find_checkmates() -> void {
+                for (auto config = black_to_move_bit_; config < num_configs_; ++config) {
+                    if (legal_[config] == 0 or not is_owned(config)) continue;
+
+                    auto const squares = squares_of(config);
+                    auto const in_check = king_attacked_squares(squares, occupied_by_others(squares), true) & legal_[config];
+                    if (in_check == 0) continue;
+
+                    auto const has_capture = KERNELS.at_least(&captures_[local_config(config) * NUM_BOARD_SQUARES], NO_CAPTURE + 1);
+
+                    auto const has_move = moves_into(config, [this](std::uint64_t const successor) { return legal_[successor]; }) | has_capture;
+                    checkmates_[local_config(config)] = in_check & ~has_move;
+                }
+            }
+
+            // Black to move positions with a move that escapes every forced win found so far, i.e.
+            // a legal move to a position not yet won or a capture that is not decided by this depth
+            auto black_escapes(std::uint64_t const config, int const depth) const -> Bits {
+                return moves_into(config, [this](std::uint64_t const successor) { return legal_[successor] & ~won_[successor]; })
+                    | KERNELS.at_least(&captures_[local_config(config) * NUM_BOARD_SQUARES], static_cast<std::uint8_t>(depth + 1));
+            }
+
+            // The axis squares from which the player to move has a (non-capturing) move into the
+            // target positions of the successor config
+            template <typename Targets>
+            auto moves_into(std::uint64_t const config, Targets const& targets) const -> Bits {
+                auto const isWhiteTurn = (config & black_to_move_bit_) == 0;
+                auto const squares = squares_of(config);
+                auto const others = occupied_by_others(squares);
+                auto res = Bits{0};
+
+                if (is_white_piece(axis_piece()) == isWhiteTurn) {
+                    res |= moves_of_set(axis_piece(), targets(config ^ black_to_move_bit_), ~others) & ~others;
+                }
+
+                material_.for_each_fixed_piece([&](auto const piece) {
+                    if (is_white_piece(material_.piece(piece)) != isWhiteTurn) return;
+                    auto const from = squares[static_cast<std::size_t>(piece)];
+                    auto destinations = attacks_of(material_.piece(piece), from, others) & ~others;
+                    while (destinations) {
+                        auto const to = std::countr_zero(destinations);
+                        destinations &= destinations - 1;
+                        res |= targets(config_after_move(config, piece, to)) & ~SQUARES_BETWEEN[from][to];
+                    }
+                });
+                return res;
+            }
+
+            // Adds every position from which the player to move reaches one of the positions in
+            // the config (with the other player to move) through a non-capturing move
+            auto add_unmove_predecessors(std::uint64_t const config, Bits const positions, bool const isWhiteMover, std::vector<std::uint64_t>& candidate_configs) -> void {
+                auto const squares = squares_of(config);
+                auto const others = occupied_by_others(squares);
+
+                if (is_white_piece(axis_piece()) == isWhiteMover) {
+                    add_candidates(config ^ black_to_move_bit_, moves_of_set(axis_piece(), positions, ~others) & ~others, candidate_configs);
+                }
+
+                material_.for_each_fixed_piece([&](auto const piece) {
+                    if (is_white_piece(material_.piece(piece)) != isWhiteMover) return;
+                    auto const to = squares[static_cast<std::size_t>(piece)];
+                    auto origins = attacks_of(material_.piece(piece), to, others) & ~others;
+                    while (origins) {
+                        auto const from = std::countr_zero(origins);
+                        origins &= origins - 1;
+                        // the axis piece can neither block the move nor stand on the origin square
+                        add_candidates(
+                            config_after_move(config, piece, from),
+                            positions & ~SQUARES_BETWEEN[from][to] & ~(Bits{1} << from),
+                            candidate_configs
+                        );
+                    }
+                });
+            }
+
+            SolverStrategy strategy_;
+            ShardExchange const* exchange_;
+            Material material_;
+            std::string signature_;
+            int max_depth_to_mate_;
+            std::uint64_t num_configs_;
+            std::uint64_t black_to_move_bit_;
+            std::array<DenseTable const*, MAX_PIECES> capture_tables_{};
+            KingPairRange king_pairs_;
+            std::uint64_t configs_per_king_pair_;
+            std::uint64_t num_local_configs_;
+
+            // one word per config, with a bit per square of the axis piece, where legal_ and won_
+            // cover every config while the rest only cover the configs this shard owns
+            TableVector<Bits> legal_;
+            TableVector<Bits> won_;
+            TableVector<Bits> checkmates_;
+            TableVector<Bits> candidates_;
+            // one byte per position of the owned configs, using the dense table layout
+            TableVector<std::uint8_t> entries_;
+            TableVector<std::uint8_t> captures_;
+            // positions (by index) whose captures decide them at each depth
+            std::vector<std::vector<std::uint64_t>> capture_seeds_;
+            // predecessors in other shards' configs, by shard, which are sent at the next exchange
+            std::vector<std::vector<ConfigBits>> outgoing_candidates_;
+        };
+
+        // Specialised solvers are built for every pawnless signature of at most this many pieces,
+        // i.e. every signature the engine can solve in reasonable memory (about 5 * 64^4 bytes for
+        // 4 pieces). Larger signatures use the RuntimeMaterial solver.
+        auto constexpr MAX_SPECIALISED_PIECES = 4;
+        auto constexpr NON_KING_PIECES = std::array{'B', 'N', 'Q', 'R', 'b', 'n', 'q', 'r'};
+        // kK, then kK with one piece, then kK with a pair of pieces (in signature order)
+        auto constexpr NUM_SPECIALISED_SIGNATURES = 1 + 8 + 8 * 9 / 2;
+
+        auto constexpr specialised_signatures() -> std::array<StaticSignature, NUM_SPECIALISED_SIGNATURES> {
+            auto signatures = std::array<StaticSignature, NUM_SPECIALISED_SIGNATURES>{};
+            auto count = std::size_t{0};
+            auto add = [&](std::string_view const extra_pieces) {
+                auto& signature = signatures[count++];
+                signature.pieces[0] = 'k';
+                signature.pieces[1] = 'K';
+                for (auto i = std::size_t{0}; i < extra_pieces.size(); ++i) {
+                    signature.pieces[2 + i] = extra_pieces[i];
+                }
+                signature.size = static_cast<int>(2 + extra_pieces.size());
+            };
+
+            add("");
+            for (auto first = std::size_t{0}; first < NON_KING_PIECES.size(); ++first) {
+                add(std::string_view(&NON_KING_PIECES[first], 1));
+            }
+            for (auto first = std::size_t{0}; first < NON_KING_PIECES.size(); ++first) {
+                for (auto second = first; second < NON_KING_PIECES.size(); ++second) {
+                    char const pair[] = {NON_KING_PIECES[first], NON_KING_PIECES[second]};
+                    add(std::string_view(pair, 2));
+                }
+            }
+            return signatures;
+        }
+
+        auto constexpr SPECIALISED_SIGNATURES = specialised_signatures();
+        static_assert(SPECIALISED_SIGNATURES.back().view() == "kKrr");
+        static_assert(SPECIALISED_SIGNATURES.back().size == MAX_SPECIALISED_PIECES);
+
+        using SolveFunction = DenseTable (*)(
+            std::string const& signature,
+            int const max_depth_to_mate,
+            std::map<std::string, DenseTable> const& solved_tables,
+            SolverStrategy const strategy,
+            ShardExchange const* const exchange
+        );
+
+        template <typename Material>
+        auto solve_with_material(
+            std::string const& signature,
+            int const max_depth_to_mate,
+            std::map<std::string, DenseTable> const& solved_tables,
+            SolverStrategy const strategy,
+            ShardExchange const* const exchange
+        ) -> DenseTable {
+            if constexpr (std::is_same_v<Material, RuntimeMaterial>) {
+                return BitboardSolver(RuntimeMaterial(signature), max_depth_to_mate, solved_tables, strategy, exchange).solve();
+            } else {
+                return BitboardSolver(Material{}, max_depth_to_mate, solved_tables, strategy, exchange).solve();
+            }
+        }
+
+        struct SpecialisedSolver {
+            std::string_view signature;
+            SolveFunction solve;
+        };
+
+        template <std::size_t... I>
+        auto constexpr specialised_solvers(std::index_sequence<I...>) -> std::array<SpecialisedSolver, sizeof...(I)> {
+            return {SpecialisedSolver{SPECIALISED_SIGNATURES[I].view(), solve_with_material<StaticMaterial<SPECIALISED_SIGNATURES[I]>>}...};
+        }
+
+        // The runtime dispatch table, sorted by signature for binary search
+        auto const SPECIALISED_SOLVERS = [] {
+            auto solvers = specialised_solvers(std::make_index_sequence<NUM_SPECIALISED_SIGNATURES>{});
+            std::sort(solvers.begin(), solvers.end(), [](SpecialisedSolver const& lhs, SpecialisedSolver const& rhs) {
+                return lhs.signature < rhs.signature;
+            });
+            return solvers;
+        }();
+
+        auto find_specialised_solver(std::string const& signature) -> SpecialisedSolver const* {
+            auto const canonical_signature = signature_for_pieces(std::vector<char>{signature.begin(), signature.end()});
+            auto const solver = std::lower_bound(SPECIALISED_SOLVERS.begin(), SPECIALISED_SOLVERS.end(), canonical_signature, [](SpecialisedSolver const& lhs, std::string const& rhs) {
+                return lhs.signature < rhs;
+            });
+            if (solver == SPECIALISED_SOLVERS.end() or solver->signature != canonical_signature) {
+                return nullptr;
+            }
+            return &*solver;
+        }
+
+        auto solve_with_dispatch(
+            std::string const& signature,
+            int const max_depth_to_mate,
+            std::map<std::string, DenseTable> const& solved_tables,
+            SolverStrategy const strategy,
+            ShardExchange const* const exchange
+        ) -> DenseTable {
+            auto const specialised = find_specialised_solver(signature);
+            auto const solve = specialised ? specialised->solve : solve_with_material<RuntimeMaterial>;
+            return solve(signature, max_depth_to_mate, solved_tables, strategy, exchange);
+        }
+    }
+
+
+    auto solve_signature_with_bitboards(
+        std::string const& signature,
+        int const max_depth_to_mate,
+        std::map<std::string, DenseTable> const& solved_tables,
+        SolverStrategy const strategy
+    ) -> DenseTable {
+        return solve_with_dispatch(signature, max_depth_to_mate, solved_tables, strategy, nullptr);
+    }
+
+    auto solve_signature_with_generic_bitboards(
+        std::string const& signature,
+        int const max_depth_to_mate,
+        std::map<std::string, DenseTable> const& solved_tables,
+        SolverStrategy const strategy
+    ) -> DenseTable {
+        return solve_with_material<RuntimeMaterial>(signature, max_depth_to_mate, solved_tables, strategy, nullptr);
+    }
+
+    auto has_specialised_bitbase_solver(std::string const& signature) -> bool {
+        return find_specialised_solver(signature) != nullptr;
+    }
+
+    auto solve_signatures_with_bitboards(
+        std::set<std::string> const& signatures,
+        int const max_depth_to_mate,
+        SolverStrategy const strategy,
+        std::function<void(DenseTable const&)> const& on_solved
+    ) -> std::map<std::string, DenseTable> {
+        auto ordered_signatures = std::vector<std::string>{};
+        for (auto const& signature : signatures) {
+            ordered_signatures.emplace_back(signature_for_pieces(std::vector<char>{signature.begin(), signature.end()}));
+        }
+        std::stable_sort(ordered_signatures.begin(), ordered_signatures.end(), [](std::string const& lhs, std::string const& rhs) {
+            return lhs.size() < rhs.size();
+        });
+
+        auto tables = std::map<std::string, DenseTable>{};
+        for (auto const& signature : ordered_signatures) {
+            auto const solved = tables.emplace(signature, solve_signature_with_bitboards(signature, max_depth_to_mate, tables, strategy));
+            if (on_solved) {
+                on_solved(solved.first->second);
+            }
+        }
+        return tables;
+    }
+
+    auto solve_signature_shard_with_bitboards(
+        std::string const& signature,
+        int const max_depth_to_mate,
+        std::map<std::string, DenseTable> const& solved_tables,
+        ShardExchange const& exchange
+    ) -> DenseTable {
+        return solve_with_dispatch(signature, max_depth_to_mate, solved_tables, SolverStrategy::FRONTIER, &exchange);
+    }
+
+    auto supported_byte_mask_kernels() -> std::vector<ByteMaskKernels> {
+        auto kernels = std::vector<ByteMaskKernels>{{"scalar", scalar_equal_to, scalar_at_least}};
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2")) {
+            kernels.emplace_back(ByteMaskKernels{"avx2", avx2_equal_to, avx2_at_least});
+        }
+#endif
+        return kernels;
+    }
+
+    auto bitbase_sweep_instruction_set() -> std::string const& {
+        return KERNELS.name;
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef COMP3821_PROJ_BITBASE_SOLVER_HEADER
+#define COMP3821_PROJ_BITBASE_SOLVER_HEADER
+
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <functional>
+#include <cstdint>
+#include "position_index.h"
+#include "sharding.h"
+
+namespace tablebase {
+    // How the bitbase solver finds the positions won at each depth:
+    // - FRONTIER un-moves only the positions won at the previous depth (as our FEN solver does),
+    //   which is cheap while few positions are being won.
+    // - SWEEP scans every position of the player to move and checks for a move into the previous
+    //   depth's wins, reading the tables sequentially in chunks of 64 bytes with AVX2 (when the
+    //   CPU supports it), which is faster at the depths where most of the table changes.
+    // Both give identical tables.
+    enum class SolverStrategy {
+        FRONTIER,
+        SWEEP,
+    };
+
+    // Solves a pawnless signature by retrograde analysis over bitboards instead of FEN strings. All
+    // pieces but the last piece of the signature (the "axis" piece) are held fixed, and the set of
+    // positions over the axis piece's 64 squares is a single 64 bit word, which lines up with the
+    // lowest 6 bits of the PositionIndexer layout. Un-moves and moves of the axis piece are then
+    // computed for 64 positions at once with shifts (kings and knights) and Kogge-Stone fills
+    // (sliders), while moves of every other piece are applied to whole words with a between mask
+    // for the squares where the axis piece would block them.
+    // Captures lead into smaller signatures, which must already be solved and be in solved_tables
+    // (including signatures without any forced wins), otherwise std::runtime_error is thrown.
+    // The result matches dense_tables_from_tablebase applied to our scalar generator's output.
+    // Every pawnless signature of at most 4 pieces has a solver specialised on its pieces at
+    // compile time (so its loops over the pieces are unrolled and the moves, attacks and colour
+    // of each piece are known), which is picked at runtime by signature.
+    auto solve_signature_with_bitboards(
+        std::string const& signature,
+        int const max_depth_to_mate,
+        std::map<std::string, DenseTable> const& solved_tables,
+        SolverStrategy const strategy = SolverStrategy::FRONTIER
+    ) -> DenseTable;
+
+    // As solve_signature_with_bitboards, but always using the solver which reads the signature at
+    // runtime, as is done for signatures without a specialised solver
+    auto solve_signature_with_generic_bitboards(
+        std::string const& signature,
+        int const max_depth_to_mate,
+        std::map<std::string, DenseTable> const& solved_tables,
+        SolverStrategy const strategy = SolverStrategy::FRONTIER
+    ) -> DenseTable;
+
+    // Whether solve_signature_with_bitboards has a solver specialised on the signature's pieces
+    auto has_specialised_bitbase_solver(std::string const& signature) -> bool;
+
+    // Solves each signature (which must be closed under captures, as the piece combinations our
+    // generator uses are) from the fewest pieces upwards, returning a table for every signature.
+    // on_solved is called with each table as soon as it is solved, and the table stays where it is
+    // (and unchanged) while the remaining signatures are solved.
+    auto solve_signatures_with_bitboards(
+        std::set<std::string> const& signatures,
+        int const max_depth_to_mate,
+        SolverStrategy const strategy = SolverStrategy::FRONTIER,
+        std::function<void(DenseTable const&)> const& on_solved = {}
+    ) -> std::map<std::string, DenseTable>;
+
+    // Solves the part of a signature (with at least 3 pieces) whose king pairs are owned by the
+    // exchange's shard, returning a table holding only those entries (see ShardExchange). Every
+    // other shard has to be solving the same signature at the same time, as the shards exchange the
+    // wins and predecessors crossing between them at each depth through the exchange. Each shard
+    // keeps the legal and won positions of the whole signature (a bit per position), while the
+    // entries and captures (two bytes per position) are only kept for its own positions.
+    // Only the frontier strategy can be sharded.
+    auto solve_signature_shard_with_bitboards(
+        std::string const& signature,
+        int const max_depth_to_mate,
+        std::map<std::string, DenseTable> const& solved_tables,
+        ShardExchange const& exchange
+    ) -> DenseTable;
+
+    // Masks over the 64 bytes of one config (one byte per square of the axis piece), which are
+    // how the byte tables are turned into bitboards. The sweep strategy runs these over whole
+    // tables every depth, so an AVX2 version is used whenever the CPU supports it.
+    struct ByteMaskKernels {
+        std::string name;
+        // bit i is set where bytes[i] == value
+        std::uint64_t (*equal_to)(std::uint8_t const* bytes, std::uint8_t value);
+        // bit i is set where bytes[i] >= value (as unsigned bytes)
+        std::uint64_t (*at_least)(std::uint8_t const* bytes, std::uint8_t value);
+    };
+
+    // The kernels of every instruction set the CPU supports, starting with the scalar kernels and
+    // ending with the ones the sweep strategy uses
+    auto supported_byte_mask_kernels() -> std::vector<ByteMaskKernels>;
+
+    // The instruction set picked at runtime for the sweep strategy's kernels, i.e. "avx2" or
+    // "scalar"
+    auto bitbase_sweep_instruction_set() -> std::string const&;
+}
+
+
+#endif // COMP3821_PROJ_BITBASE_SOLVER_HEADER
@@ -0,0 +1,98 @@
+#include "./test_fixtures.h"
+#include "./position_index.h"
+#include "./bitbase_solver.h"
+#include <catch.hpp>
+#include <random>
+#include <array>
+
+TEST_CASE("Solving with bitboards matches our generator") {
+    auto const max_depth_to_mate = 9;
+    auto const kK = tablebase::DenseTable{"kK", max_depth_to_mate, tablebase::TableVector<std::uint8_t>(tablebase::PositionIndexer("kK").size(), tablebase::NOT_A_FORCED_WIN)};
+
+    for (auto const& pieces : {std::vector<char>{{'k', 'K', 'R'}}, std::vector<char>{{'k', 'K', 'Q'}}}) {
+        auto const signature = tablebase::signature_for_pieces(pieces);
+        auto const& tablebase = fixtures::generated_tablebase(max_depth_to_mate, 3, pieces);
+        auto const expected = tablebase::dense_tables_from_tablebase(tablebase, max_depth_to_mate);
+
+        for (auto const strategy : {tablebase::SolverStrategy::FRONTIER, tablebase::SolverStrategy::SWEEP}) {
+            auto const solved = tablebase::solve_signature_with_bitboards(signature, max_depth_to_mate, {{"kK", kK}}, strategy);
+            CHECK(solved.signature == signature);
+            CHECK(solved.max_depth_to_mate == max_depth_to_mate);
+            CHECK(solved.entries == expected.at(signature).entries);
+        }
+    }
+}
+
+TEST_CASE("Solving four pieces with bitboards matches our generator", "[.][four_pieces]") {
+    // shared with the end-to-end tests for kKQn, so this only costs the comparison
+    auto const max_depth_to_mate = 5;
+    auto const& tablebase = fixtures::generated_tablebase(max_depth_to_mate, 4, std::vector<char>{{'k', 'K', 'Q', 'n'}});
+    auto const expected = tablebase::dense_tables_from_tablebase(tablebase, max_depth_to_mate);
+
+    // our generator also uncaptures into signatures such as kKQq without solving them completely,
+    // so only the subsets of kKQn are compared (kK and kKn have no forced wins)
+    auto const solved = tablebase::solve_signatures_with_bitboards({"kK", "kKQ", "kKn", "kKQn"}, max_depth_to_mate);
+    for (auto const& signature : {"kKQ", "kKQn"}) {
+        CHECK(solved.at(signature).entries == expected.at(signature).entries);
+    }
+    CHECK(not expected.contains("kKn"));
+}
+
+TEST_CASE("Solving with bitboards requires the tables of every capture") {
+    CHECK_THROWS_AS(tablebase::solve_signature_with_bitboards("kKR", 4, {}), std::runtime_error);
+
+    auto const tables = tablebase::solve_signatures_with_bitboards({"kK", "kKR"}, 4);
+    CHECK(tables.contains("kK"));
+    CHECK(tables.contains("kKR"));
+}
+
+TEST_CASE("Both bitbase strategies agree when captures are involved") {
+    auto const frontier = tablebase::solve_signatures_with_bitboards({"kK", "kKR", "kKn", "kKRn"}, 5, tablebase::SolverStrategy::FRONTIER);
+    auto const sweep = tablebase::solve_signatures_with_bitboards({"kK", "kKR", "kKn", "kKRn"}, 5, tablebase::SolverStrategy::SWEEP);
+    CHECK(frontier.at("kKRn").entries == sweep.at("kKRn").entries);
+}
+
+TEST_CASE("Specialised bitbase solvers match the generic solver") {
+    CHECK(tablebase::has_specialised_bitbase_solver("kK"));
+    CHECK(tablebase::has_specialised_bitbase_solver("KkRn"));
+    CHECK(tablebase::has_specialised_bitbase_solver("kKrr"));
+    CHECK_FALSE(tablebase::has_specialised_bitbase_solver("kKBNN"));
+
+    auto const max_depth_to_mate = 5;
+    auto const tables = tablebase::solve_signatures_with_bitboards({"kK", "kKB", "kKR", "kKn", "kKBB", "kKRn"}, max_depth_to_mate);
+    for (auto const& signature : {"kKBB", "kKRn"}) {
+        for (auto const strategy : {tablebase::SolverStrategy::FRONTIER, tablebase::SolverStrategy::SWEEP}) {
+            auto const generic = tablebase::solve_signature_with_generic_bitboards(signature, max_depth_to_mate, tables, strategy);
+            CHECK(generic.entries == tables.at(signature).entries);
+        }
+    }
+}
+
+TEST_CASE("Every supported byte mask kernel matches the scalar kernels") {
+    auto const kernels = tablebase::supported_byte_mask_kernels();
+    REQUIRE(kernels.front().name == "scalar");
+    CHECK(kernels.back().name == tablebase::bitbase_sweep_instruction_set());
+
+    auto random = std::mt19937_64{3821};
+    auto bytes = std::array<std::uint8_t, 64>{};
+    for (auto trial = 0; trial < 1000; ++trial) {
+        // every other trial only uses a few values around 128, so that equal bytes are common and
+        // the signed and unsigned comparisons of bytes would disagree
+        for (auto& byte : bytes) {
+            byte = static_cast<std::uint8_t>((trial % 2 == 0) ? random() : 126 + random() % 4);
+        }
+        for (auto const value : {std::uint8_t{0}, std::uint8_t{1}, std::uint8_t{127}, std::uint8_t{128}, std::uint8_t{255}, bytes[random() % 64]}) {
+            auto expected_equal_to = std::uint64_t{0};
+            auto expected_at_least = std::uint64_t{0};
+            for (auto square = 0; square < 64; ++square) {
+                expected_equal_to |= static_cast<std::uint64_t>(bytes[static_cast<std::size_t>(square)] == value) << square;
+                expected_at_least |= static_cast<std::uint64_t>(bytes[static_cast<std::size_t>(square)] >= value) << square;
+            }
+            for (auto const& kernel : kernels) {
+                INFO(kernel.name);
+                CHECK(kernel.equal_to(bytes.data(), value) == expected_equal_to);
+                CHECK(kernel.at_least(bytes.data(), value) == expected_at_least);
+            }
+        }
+    }
+}
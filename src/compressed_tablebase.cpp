@@ -0,0 +1,557 @@
+#include <vector>
+#include <string>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <filesystem>
+#include <fstream>
+#include <tuple>
+#include <functional>
+#include "compressed_tablebase.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        auto const MAGIC = std::array<char, 4>{'T', 'B', 'Z', '1'};
+        auto const FORMAT_VERSION = std::uint32_t{2};
+
+        // Each compressed block starts with one of these to say how the rest of it is encoded
+        auto const RAW_BLOCK = std::uint8_t{0};
+        auto const RUN_LENGTH_BLOCK = std::uint8_t{1};
+        // A 64 bit run length takes at most 10 bytes of 7 bits
+        auto const MAX_VARINT_SHIFT = 63;
+
+        template <typename T>
+        auto write_value(std::ofstream& file, T const& value) -> void {
+            file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        auto read_value(std::ifstream& file) -> T {
+            auto value = T{};
+            file.read(reinterpret_cast<char*>(&value), sizeof(T));
+            return value;
+        }
+
+        // Run lengths are stored as LEB128 style variable length integers
+        auto append_varint(std::vector<std::uint8_t>& output, std::uint64_t value) -> void {
+            while (value >= 0x80) {
+                output.push_back(static_cast<std::uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            output.push_back(static_cast<std::uint8_t>(value));
+        }
+
+        // Throws std::runtime_error rather than reading past the end, so corrupt blocks are reported
+        auto read_varint(std::uint8_t const* input, std::size_t& position, std::size_t const end) -> std::uint64_t {
+            auto value = std::uint64_t{0};
+            auto shift = 0;
+            while (position < end and (input[position] & 0x80)) {
+                if (shift > MAX_VARINT_SHIFT) {
+                    throw std::runtime_error("Run length of compressed block is too long");
+                }
+                value |= static_cast<std::uint64_t>(input[position] & 0x7F) << shift;
+                shift += 7;
+                ++position;
+            }
+            if (position >= end or shift > MAX_VARINT_SHIFT) {
+                throw std::runtime_error("Run length runs past the end of its compressed block");
+            }
+            value |= static_cast<std::uint64_t>(input[position]) << shift;
+            ++position;
+            return value;
+        }
+
+        auto encode_block(std::uint8_t const* symbols, std::size_t const num_symbols) -> std::vector<std::uint8_t> {
+            auto encoded = std::vector<std::uint8_t>{RUN_LENGTH_BLOCK};
+            for (auto i = std::size_t{0}; i < num_symbols;) {
+                auto run_end = i + 1;
+                while (run_end < num_symbols and symbols[run_end] == symbols[i]) {
+                    ++run_end;
+                }
+                encoded.push_back(symbols[i]);
+                append_varint(encoded, run_end - i);
+                i = run_end;
+            }
+
+            // Blocks with many short runs are cheaper to store as they are
+            if (encoded.size() > num_symbols + 1) {
+                encoded.assign(1, RAW_BLOCK);
+                encoded.insert(encoded.end(), symbols, symbols + num_symbols);
+            }
+            return encoded;
+        }
+
+        // White to move positions make up the first half of the index range (see PositionIndexer)
+        auto stored_range(std::uint64_t const size, StoredSides const stored_sides) -> std::pair<std::uint64_t, std::uint64_t> {
+            switch (stored_sides) {
+                case StoredSides::WHITE_TO_MOVE:
+                    return {0, size / 2};
+                case StoredSides::BLACK_TO_MOVE:
+                    return {size / 2, size};
+                default:
+                    return {0, size};
+            }
+        }
+
+        struct SymbolMapping {
+            std::vector<std::uint8_t> symbol_to_entry;
+            std::array<std::uint8_t, 256> entry_to_symbol;
+        };
+
+        // Ranks the entries by frequency so that the most common values get the smallest symbols
+        auto rank_symbols_by_frequency(
+            TableVector<std::uint8_t> const& entries,
+            std::uint64_t const begin,
+            std::uint64_t const end
+        ) -> SymbolMapping {
+            auto frequencies = std::array<std::uint64_t, 256>{};
+            for (auto i = begin; i < end; ++i) {
+                ++frequencies[entries[i]];
+            }
+
+            auto mapping = SymbolMapping{std::vector<std::uint8_t>(256), {}};
+            std::iota(mapping.symbol_to_entry.begin(), mapping.symbol_to_entry.end(), 0);
+            std::stable_sort(mapping.symbol_to_entry.begin(), mapping.symbol_to_entry.end(), [&](std::uint8_t const lhs, std::uint8_t const rhs) {
+                return frequencies[lhs] > frequencies[rhs];
+            });
+            while (mapping.symbol_to_entry.size() > 1 and frequencies[mapping.symbol_to_entry.back()] == 0) {
+                mapping.symbol_to_entry.pop_back();
+            }
+
+            for (auto symbol = std::size_t{0}; symbol < mapping.symbol_to_entry.size(); ++symbol) {
+                mapping.entry_to_symbol[mapping.symbol_to_entry[symbol]] = static_cast<std::uint8_t>(symbol);
+            }
+            return mapping;
+        }
+
+        template <typename Callback>
+        auto for_each_encoded_block(
+            TableVector<std::uint8_t> const& entries,
+            std::uint64_t const begin,
+            std::uint64_t const end,
+            std::uint32_t const block_size,
+            SymbolMapping const& mapping,
+            Callback&& callback
+        ) -> void {
+            auto symbols = std::vector<std::uint8_t>(block_size);
+            for (auto start = begin; start < end; start += block_size) {
+                auto const length = std::min<std::uint64_t>(block_size, end - start);
+                for (auto i = std::uint64_t{0}; i < length; ++i) {
+                    symbols[i] = mapping.entry_to_symbol[entries[start + i]];
+                }
+                callback(encode_block(symbols.data(), length));
+            }
+        }
+    }
+
+
+    auto write_compressed_table(
+        DenseTable const& table,
+        std::string const& path,
+        std::uint32_t const block_size,
+        StoredSides const stored_sides
+    ) -> std::uint64_t {
+        auto const size = static_cast<std::uint64_t>(table.entries.size());
+        auto const [stored_begin, stored_end] = stored_range(size, stored_sides);
+        auto const symbols = rank_symbols_by_frequency(table.entries, stored_begin, stored_end);
+        auto const num_blocks = (stored_end - stored_begin + block_size - 1) / block_size;
+
+        auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+        if (not file) {
+            throw std::runtime_error("Unable to open " + path + " for writing");
+        }
+
+        file.write(MAGIC.data(), MAGIC.size());
+        write_value(file, FORMAT_VERSION);
+        write_value(file, static_cast<std::uint32_t>(table.signature.size()));
+        file.write(table.signature.data(), static_cast<std::streamsize>(table.signature.size()));
+        write_value(file, static_cast<std::int32_t>(table.max_depth_to_mate));
+        write_value(file, size);
+        write_value(file, static_cast<std::uint8_t>(stored_sides));
+        write_value(file, block_size);
+        write_value(file, num_blocks);
+        write_value(file, static_cast<std::uint32_t>(symbols.symbol_to_entry.size()));
+        file.write(reinterpret_cast<char const*>(symbols.symbol_to_entry.data()), static_cast<std::streamsize>(symbols.symbol_to_entry.size()));
+
+        // The block index is filled in once every block has been written
+        auto const block_index_position = file.tellp();
+        auto block_offsets = std::vector<std::uint64_t>(num_blocks + 1, 0);
+        file.write(reinterpret_cast<char const*>(block_offsets.data()), static_cast<std::streamsize>(block_offsets.size() * sizeof(std::uint64_t)));
+
+        auto block = std::uint64_t{0};
+        for_each_encoded_block(table.entries, stored_begin, stored_end, block_size, symbols, [&](std::vector<std::uint8_t> const& encoded) {
+            file.write(reinterpret_cast<char const*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+            block_offsets[block + 1] = block_offsets[block] + encoded.size();
+            ++block;
+        });
+
+        auto const file_size = static_cast<std::uint64_t>(file.tellp());
+        file.seekp(block_index_position);
+        file.write(reinterpret_cast<char const*>(block_offsets.data()), static_cast<std::streamsize>(block_offsets.size() * sizeof(std::uint64_t)));
+
+        if (not file) {
+            throw std::runtime_error("Failed while writing " + path);
+        }
+        return file_size;
+    }
+
+    auto choose_side_to_store(DenseTable const& table, std::uint32_t const block_size) -> StoredSides {
+        auto const size = static_cast<std::uint64_t>(table.entries.size());
+        auto encoded_sizes = std::map<StoredSides, std::uint64_t>{};
+
+        for (auto const stored_sides : {StoredSides::WHITE_TO_MOVE, StoredSides::BLACK_TO_MOVE}) {
+            auto const [stored_begin, stored_end] = stored_range(size, stored_sides);
+            auto const symbols = rank_symbols_by_frequency(table.entries, stored_begin, stored_end);
+            for_each_encoded_block(table.entries, stored_begin, stored_end, block_size, symbols, [&](std::vector<std::uint8_t> const& encoded) {
+                encoded_sizes[stored_sides] += encoded.size();
+            });
+        }
+
+        return (encoded_sizes[StoredSides::WHITE_TO_MOVE] <= encoded_sizes[StoredSides::BLACK_TO_MOVE])
+            ? StoredSides::WHITE_TO_MOVE
+            : StoredSides::BLACK_TO_MOVE;
+    }
+
+
+    BlockCache::BlockCache(std::size_t const capacity_in_blocks)
+    : capacity_in_blocks_{std::max<std::size_t>(capacity_in_blocks, 1)} {}
+
+    auto BlockCache::KeyHash::operator()(Key const& key) const -> std::size_t {
+        return std::hash<CompressedTable const*>{}(key.first) ^ (std::hash<std::uint64_t>{}(key.second) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    auto BlockCache::get_block(
+        CompressedTable const& table,
+        std::uint64_t const block
+    ) -> std::shared_ptr<std::vector<std::uint8_t> const> {
+        auto const key = Key{&table, block};
+        {
+            auto const lock = std::lock_guard(mutex_);
+            auto const iter = blocks_.find(key);
+            if (iter != blocks_.end()) {
+                ++hits_;
+                recency_.splice(recency_.begin(), recency_, iter->second.second);
+                return iter->second.first;
+            }
+            ++misses_;
+        }
+
+        // Decompress without holding the lock so that other threads can keep probing
+        auto decompressed = std::make_shared<std::vector<std::uint8_t> const>(table.decompress_block(block));
+
+        auto const lock = std::lock_guard(mutex_);
+        auto const iter = blocks_.find(key);
+        if (iter != blocks_.end()) {
+            // another thread loaded the same block in the meantime
+            return iter->second.first;
+        }
+
+        recency_.push_front(key);
+        blocks_.emplace(key, Entry{decompressed, recency_.begin()});
+        while (blocks_.size() > capacity_in_blocks_) {
+            blocks_.erase(recency_.back());
+            recency_.pop_back();
+        }
+        return decompressed;
+    }
+
+    auto BlockCache::hits() const -> std::uint64_t {
+        auto const lock = std::lock_guard(mutex_);
+        return hits_;
+    }
+
+    auto BlockCache::misses() const -> std::uint64_t {
+        auto const lock = std::lock_guard(mutex_);
+        return misses_;
+    }
+
+
+    CompressedTable::CompressedTable(std::string const& path)
+    : file_(path, std::ios::binary) {
+        if (not file_) {
+            throw std::runtime_error("Unable to open compressed table " + path);
+        }
+
+        auto magic = std::array<char, 4>{};
+        file_.read(magic.data(), magic.size());
+        if (magic != MAGIC or read_value<std::uint32_t>(file_) != FORMAT_VERSION) {
+            throw std::runtime_error(path + " is not a compressed table supported by this version");
+        }
+
+        signature_.resize(read_value<std::uint32_t>(file_));
+        file_.read(signature_.data(), static_cast<std::streamsize>(signature_.size()));
+        max_depth_to_mate_ = read_value<std::int32_t>(file_);
+        size_ = read_value<std::uint64_t>(file_);
+        stored_sides_ = static_cast<StoredSides>(read_value<std::uint8_t>(file_));
+        std::tie(stored_begin_, stored_end_) = stored_range(size_, stored_sides_);
+        block_size_ = read_value<std::uint32_t>(file_);
+        auto const num_blocks = read_value<std::uint64_t>(file_);
+
+        auto const num_symbols = read_value<std::uint32_t>(file_);
+        if (num_symbols > 256) {
+            throw std::runtime_error(path + " has a corrupt header");
+        }
+        symbol_to_entry_.resize(num_symbols);
+        file_.read(reinterpret_cast<char*>(symbol_to_entry_.data()), static_cast<std::streamsize>(symbol_to_entry_.size()));
+
+        // the header must describe blocks covering the stored side, so offsets can be trusted when probing
+        if (block_size_ == 0 or num_blocks != (stored_end_ - stored_begin_ + block_size_ - 1) / block_size_) {
+            throw std::runtime_error(path + " has a corrupt header");
+        }
+
+        block_offsets_.resize(num_blocks + 1);
+        file_.read(reinterpret_cast<char*>(block_offsets_.data()), static_cast<std::streamsize>(block_offsets_.size() * sizeof(std::uint64_t)));
+        data_start_ = static_cast<std::uint64_t>(file_.tellg());
+
+        if (not file_) {
+            throw std::runtime_error(path + " is truncated");
+        }
+
+        // every block holds at least its encoding byte, and the last one ends at the end of the file
+        if (block_offsets_.front() != 0 or block_offsets_.back() != std::filesystem::file_size(path) - data_start_) {
+            throw std::runtime_error(path + " has corrupt block offsets");
+        }
+        for (auto block = std::size_t{0}; block < num_blocks; ++block) {
+            if (block_offsets_[block + 1] <= block_offsets_[block]) {
+                throw std::runtime_error(path + " has corrupt block offsets");
+            }
+        }
+    }
+
+    auto CompressedTable::signature() const -> std::string const& {
+        return signature_;
+    }
+
+    auto CompressedTable::max_depth_to_mate() const -> int {
+        return max_depth_to_mate_;
+    }
+
+    auto CompressedTable::size() const -> std::uint64_t {
+        return size_;
+    }
+
+    auto CompressedTable::stored_sides() const -> StoredSides {
+        return stored_sides_;
+    }
+
+    auto CompressedTable::stores_index(std::uint64_t const index) const -> bool {
+        return stored_begin_ <= index and index < stored_end_;
+    }
+
+    auto CompressedTable::block_size() const -> std::uint32_t {
+        return block_size_;
+    }
+
+    auto CompressedTable::num_blocks() const -> std::uint64_t {
+        return block_offsets_.size() - 1;
+    }
+
+    auto CompressedTable::compressed_size() const -> std::uint64_t {
+        return data_start_ + block_offsets_.back();
+    }
+
+    auto CompressedTable::decompress_block(std::uint64_t const block) const -> std::vector<std::uint8_t> {
+        auto encoded = std::vector<std::uint8_t>(block_offsets_[block + 1] - block_offsets_[block]);
+        {
+            auto const lock = std::lock_guard(file_mutex_);
+            file_.seekg(static_cast<std::streamoff>(data_start_ + block_offsets_[block]));
+            file_.read(reinterpret_cast<char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+            if (not file_) {
+                throw std::runtime_error("Unable to read block of compressed table " + signature_);
+            }
+        }
+
+        auto const length = std::min<std::uint64_t>(block_size_, (stored_end_ - stored_begin_) - block * block_size_);
+        auto entries = std::vector<std::uint8_t>{};
+        entries.reserve(length);
+
+        if (encoded[0] == RAW_BLOCK) {
+            for (auto i = std::size_t{1}; i < encoded.size(); ++i) {
+                entries.push_back(entry_for_symbol(encoded[i]));
+            }
+        } else {
+            auto position = std::size_t{1};
+            while (position < encoded.size()) {
+                auto const entry = entry_for_symbol(encoded[position++]);
+                auto const run_length = read_varint(encoded.data(), position, encoded.size());
+                if (run_length > length - entries.size()) {
+                    throw std::runtime_error("Runs of a block of compressed table " + signature_ + " are longer than the block");
+                }
+                entries.insert(entries.end(), run_length, entry);
+            }
+        }
+
+        if (entries.size() != length) {
+            throw std::runtime_error("Block of compressed table " + signature_ + " decompresses to " + std::to_string(entries.size())
+                + " entries instead of " + std::to_string(length));
+        }
+        return entries;
+    }
+
+    auto CompressedTable::decompress_all() const -> DenseTable {
+        auto table = DenseTable{signature_, max_depth_to_mate_, TableVector<std::uint8_t>(size_, NOT_A_FORCED_WIN)};
+        for (auto block = std::uint64_t{0}; block < num_blocks(); ++block) {
+            auto const entries = decompress_block(block);
+            std::copy(entries.begin(), entries.end(), table.entries.begin() + static_cast<std::ptrdiff_t>(stored_begin_ + block * block_size_));
+        }
+        return table;
+    }
+
+    auto CompressedTable::entry_at(std::uint64_t const index, BlockCache& cache) const -> std::uint8_t {
+        auto const block = cache.get_block(*this, (index - stored_begin_) / block_size_);
+        return (*block)[(index - stored_begin_) % block_size_];
+    }
+
+    auto CompressedTable::read_encoded_blocks(TableMemory const memory) const -> TableVector<std::uint8_t> {
+        auto encoded_blocks = TableVector<std::uint8_t>(block_offsets_.back(), 0, TableAllocator<std::uint8_t>(memory));
+        auto const lock = std::lock_guard(file_mutex_);
+        file_.seekg(static_cast<std::streamoff>(data_start_));
+        file_.read(reinterpret_cast<char*>(encoded_blocks.data()), static_cast<std::streamsize>(encoded_blocks.size()));
+        if (not file_) {
+            throw std::runtime_error("Unable to read blocks of compressed table " + signature_);
+        }
+        return encoded_blocks;
+    }
+
+    auto CompressedTable::entry_in_encoded_blocks(
+        TableVector<std::uint8_t> const& encoded_blocks,
+        std::uint64_t const index
+    ) const -> std::uint8_t {
+        auto const block = (index - stored_begin_) / block_size_;
+        auto const offset = (index - stored_begin_) % block_size_;
+        auto position = static_cast<std::size_t>(block_offsets_[block]);
+        auto const block_end = static_cast<std::size_t>(block_offsets_[block + 1]);
+
+        if (encoded_blocks[position] == RAW_BLOCK) {
+            if (position + 1 + offset >= block_end) {
+                throw std::runtime_error("Raw block of compressed table " + signature_ + " is too short");
+            }
+            return entry_for_symbol(encoded_blocks[position + 1 + offset]);
+        }
+
+        ++position;
+        auto run_end = std::uint64_t{0};
+        while (position < block_end) {
+            auto const symbol = encoded_blocks[position++];
+            run_end += read_varint(encoded_blocks.data(), position, block_end);
+            if (offset < run_end) return entry_for_symbol(symbol);
+        }
+        throw std::runtime_error("Runs of compressed table " + signature_ + " end before the entry");
+    }
+
+    auto CompressedTable::entry_for_symbol(std::uint8_t const symbol) const -> std::uint8_t {
+        if (symbol >= symbol_to_entry_.size()) {
+            throw std::runtime_error("Unknown symbol in compressed table " + signature_);
+        }
+        return symbol_to_entry_[symbol];
+    }
+
+
+    auto resolve_with_successors(
+        chess::Board& board,
+        int const max_depth_to_mate,
+        std::function<int(chess::Board const&)> const& successor_depth_to_mate_of
+    ) -> int {
+        auto const isWhiteTurn = board.sideToMove() == chess::Color::WHITE;
+
+        // the player who just moved cannot have left their king in check
+        if (board.isAttacked(board.kingSq(~board.sideToMove()), board.sideToMove())) return -1;
+
+        auto movelist = chess::Movelist();
+        chess::movegen::legalmoves(movelist, board);
+
+        if (movelist.empty()) {
+            // checkmates are the only positions without moves that are wins for white
+            return (not isWhiteTurn and board.inCheck()) ? 0 : -1;
+        }
+
+        auto best_successor_depth_to_mate = -1;
+        for (auto const curr_move : movelist) {
+            board.makeMove(curr_move);
+            auto const successor_depth_to_mate = successor_depth_to_mate_of(board);
+            board.unmakeMove(curr_move);
+
+            if (isWhiteTurn) {
+                if (successor_depth_to_mate >= 0 and (best_successor_depth_to_mate == -1 or successor_depth_to_mate < best_successor_depth_to_mate)) {
+                    best_successor_depth_to_mate = successor_depth_to_mate;
+                }
+            } else {
+                // a single move for black that escapes the forced win is enough
+                if (successor_depth_to_mate < 0) return -1;
+                best_successor_depth_to_mate = std::max(best_successor_depth_to_mate, successor_depth_to_mate);
+            }
+        }
+
+        if (best_successor_depth_to_mate == -1) return -1;
+
+        // the generator would not have found states beyond the depth to mate it checked
+        auto const depth_to_mate = best_successor_depth_to_mate + 1;
+        return (depth_to_mate <= max_depth_to_mate) ? depth_to_mate : -1;
+    }
+
+
+    CompressedTablebase::CompressedTablebase(
+        std::string const& directory,
+        std::size_t const cache_capacity_in_blocks
+    ) : cache_{std::make_unique<BlockCache>(cache_capacity_in_blocks)} {
+        for (auto const& file : std::filesystem::directory_iterator(directory)) {
+            if (file.path().extension() != COMPRESSED_TABLE_EXTENSION) continue;
+
+            auto table = std::make_unique<CompressedTable>(file.path().string());
+            auto signature = table->signature();
+            tables_.emplace(signature, LoadedTable{PositionIndexer(signature), std::move(table)});
+        }
+    }
+
+    auto CompressedTablebase::get_depth_to_mate_for_state(std::string const& FEN_string) const -> int {
+        auto const iter = tables_.find(signature_of_FEN(FEN_string));
+        if (iter == tables_.end()) return -1;
+
+        auto const index = iter->second.indexer.index_of_FEN(FEN_string);
+        if (not index) return -1;
+
+        auto const& table = *iter->second.table;
+        if (not table.stores_index(*index)) {
+            auto board = chess::Board(FEN_string);
+            return resolve_with_successors(board, table.max_depth_to_mate(), [this](chess::Board const& successor) {
+                return get_depth_to_mate_for_board(successor);
+            });
+        }
+        return depth_to_mate_for_entry(table.entry_at(*index, *cache_));
+    }
+
+    auto CompressedTablebase::get_depth_to_mate_for_board(chess::Board const& board) const -> int {
+        auto const iter = tables_.find(signature_of_board(board));
+        if (iter == tables_.end()) return -1;
+
+        auto const index = iter->second.indexer.index_of_board(board);
+        if (not index) return -1;
+
+        auto const& table = *iter->second.table;
+        if (not table.stores_index(*index)) {
+            auto board_copy = board;
+            return resolve_with_successors(board_copy, table.max_depth_to_mate(), [this](chess::Board const& successor) {
+                return get_depth_to_mate_for_board(successor);
+            });
+        }
+        return depth_to_mate_for_entry(table.entry_at(*index, *cache_));
+    }
+
+    auto CompressedTablebase::contains_signature(std::string const& signature) const -> bool {
+        return tables_.contains(signature);
+    }
+
+    auto CompressedTablebase::signatures() const -> std::vector<std::string> {
+        auto res = std::vector<std::string>{};
+        for (auto const& [signature, loaded_table] : tables_) {
+            res.emplace_back(signature);
+        }
+        return res;
+    }
+
+    auto CompressedTablebase::cache() const -> BlockCache& {
+        return *cache_;
+    }
+}
@@ -0,0 +1,180 @@
+#ifndef COMP3821_PROJ_COMPRESSED_TABLEBASE_HEADER
+#define COMP3821_PROJ_COMPRESSED_TABLEBASE_HEADER
+
+#include <vector>
+#include <string>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <fstream>
+#include <cstdint>
+#include <unordered_map>
+#include <chess.hpp>
+#include "position_index.h"
+
+namespace tablebase {
+    // Number of positions per compressed block, small enough that decompressing a block on a cache
+    // miss only takes a few microseconds
+    auto constexpr DEFAULT_BLOCK_SIZE = std::uint32_t{4096};
+    auto constexpr DEFAULT_CACHE_CAPACITY_IN_BLOCKS = std::size_t{4096};
+    auto constexpr COMPRESSED_TABLE_EXTENSION = ".tbz";
+
+    // Which halves of a table (split by the player to move) are persisted. When only one half is
+    // stored, probes for the other player's turn are resolved by taking each legal move and probing
+    // the successors in the stored half (see CompressedTablebase).
+    enum class StoredSides : std::uint8_t {
+        BOTH = 0,
+        WHITE_TO_MOVE = 1,
+        BLACK_TO_MOVE = 2,
+    };
+
+    // Writes a dense table to disk split into fixed size blocks. Entries are first remapped to
+    // symbols ranked by frequency (so the most common depth to mate, usually "not a forced win", is
+    // symbol 0) and each block is then run-length encoded, falling back to storing the raw symbols
+    // for blocks that do not compress. A block index at the start of the file allows any block to
+    // be read without touching the rest of the file.
+    // Returns the size of the written file in bytes.
+    auto write_compressed_table(
+        DenseTable const& table,
+        std::string const& path,
+        std::uint32_t const block_size = DEFAULT_BLOCK_SIZE,
+        StoredSides const stored_sides = StoredSides::BOTH
+    ) -> std::uint64_t;
+
+    // Picks whichever single player's half of the table compresses to fewer bytes
+    auto choose_side_to_store(DenseTable const& table, std::uint32_t const block_size = DEFAULT_BLOCK_SIZE) -> StoredSides;
+
+    class CompressedTable;
+
+    // A least recently used cache of decompressed blocks. It is safe to share a single cache
+    // between many tables and many probing threads.
+    class BlockCache {
+    public:
+        explicit BlockCache(std::size_t const capacity_in_blocks);
+
+        // Returns the decompressed block, reading it from the table's file on a cache miss
+        auto get_block(CompressedTable const& table, std::uint64_t const block) -> std::shared_ptr<std::vector<std::uint8_t> const>;
+
+        auto hits() const -> std::uint64_t;
+        auto misses() const -> std::uint64_t;
+
+    private:
+        using Key = std::pair<CompressedTable const*, std::uint64_t>;
+        struct KeyHash {
+            auto operator()(Key const& key) const -> std::size_t;
+        };
+        using Entry = std::pair<std::shared_ptr<std::vector<std::uint8_t> const>, std::list<Key>::iterator>;
+
+        std::size_t capacity_in_blocks_;
+        mutable std::mutex mutex_;
+        // most recently used blocks are kept at the front
+        std::list<Key> recency_;
+        std::unordered_map<Key, Entry, KeyHash> blocks_;
+        std::uint64_t hits_ = 0;
+        std::uint64_t misses_ = 0;
+    };
+
+    // Random access reader for a single file produced by write_compressed_table
+    class CompressedTable {
+    public:
+        // Throws std::runtime_error if the file is missing, is not a compressed table, or its block
+        // offsets do not fit the file
+        explicit CompressedTable(std::string const& path);
+
+        auto signature() const -> std::string const&;
+        auto max_depth_to_mate() const -> int;
+        auto size() const -> std::uint64_t;
+        auto stored_sides() const -> StoredSides;
+        // Whether the entry for an index is persisted, i.e. it belongs to a stored side
+        auto stores_index(std::uint64_t const index) const -> bool;
+        auto block_size() const -> std::uint32_t;
+        auto num_blocks() const -> std::uint64_t;
+        auto compressed_size() const -> std::uint64_t;
+
+        // Reads a block from disk and decompresses it into dense table entries. Throws
+        // std::runtime_error if the block is corrupt, i.e. it does not decode to exactly the
+        // entries of the block.
+        auto decompress_block(std::uint64_t const block) const -> std::vector<std::uint8_t>;
+
+        // Decompresses every block into a dense table, leaving the entries of a side which was not
+        // stored as NOT_A_FORCED_WIN
+        auto decompress_all() const -> DenseTable;
+
+        // Returns the dense table entry for an index (see PositionIndexer), which must be stored
+        auto entry_at(std::uint64_t const index, BlockCache& cache) const -> std::uint8_t;
+
+        // Reads every encoded block into memory (about compressed_size() bytes)
+        auto read_encoded_blocks(TableMemory const memory = default_table_memory()) const -> TableVector<std::uint8_t>;
+
+        // Returns the entry for a stored index from the output of read_encoded_blocks, decoding only
+        // the runs of its block up to the entry. Neither the file nor a cache is touched, so any
+        // number of threads can probe at once without locking. Throws std::runtime_error if the
+        // block is corrupt.
+        auto entry_in_encoded_blocks(TableVector<std::uint8_t> const& encoded_blocks, std::uint64_t const index) const -> std::uint8_t;
+
+    private:
+        auto entry_for_symbol(std::uint8_t const symbol) const -> std::uint8_t;
+
+        std::string signature_;
+        int max_depth_to_mate_;
+        std::uint64_t size_;
+        StoredSides stored_sides_;
+        // the range of indices that were persisted
+        std::uint64_t stored_begin_;
+        std::uint64_t stored_end_;
+        std::uint32_t block_size_;
+        std::vector<std::uint8_t> symbol_to_entry_;
+        std::vector<std::uint64_t> block_offsets_;
+        std::uint64_t data_start_;
+
+        mutable std::mutex file_mutex_;
+        mutable std::ifstream file_;
+    };
+
+    // Resolves the depth to mate of a position whose side to move was not stored, by taking each
+    // legal move and combining the depths to mate of the successors (negative when they are not
+    // forced wins), which belong to the other player's (stored) half: white picks the quickest
+    // mate, while black is only lost if every move is, and then picks the slowest one. Returns -1
+    // if it is not a forced win within max_depth_to_mate. The board is restored before returning.
+    auto resolve_with_successors(
+        chess::Board& board,
+        int const max_depth_to_mate,
+        std::function<int(chess::Board const&)> const& successor_depth_to_mate_of
+    ) -> int;
+
+    // Every compressed table found in a directory, probed through a single shared block cache
+    class CompressedTablebase {
+    public:
+        explicit CompressedTablebase(
+            std::string const& directory,
+            std::size_t const cache_capacity_in_blocks = DEFAULT_CACHE_CAPACITY_IN_BLOCKS
+        );
+
+        // Finds the depth to mate for the state. If the state is not in the tablebase, -1 is
+        // returned (mirroring helper::get_depth_to_mate_for_state). States belonging to a side that
+        // was not stored take one extra ply of move generation and probing to resolve.
+        auto get_depth_to_mate_for_state(std::string const& FEN_string) const -> int;
+        auto get_depth_to_mate_for_board(chess::Board const& board) const -> int;
+
+        // Whether a table was found for the signature. run_engine writes a table for every signature
+        // it solves (even those without forced wins), so a missing table means nothing is known
+        // about the signature, rather than it having no forced wins for white.
+        auto contains_signature(std::string const& signature) const -> bool;
+        auto signatures() const -> std::vector<std::string>;
+        auto cache() const -> BlockCache&;
+
+    private:
+        struct LoadedTable {
+            PositionIndexer indexer;
+            std::unique_ptr<CompressedTable> table;
+        };
+
+        std::map<std::string, LoadedTable> tables_;
+        std::unique_ptr<BlockCache> cache_;
+    };
+}
+
+
+#endif // COMP3821_PROJ_COMPRESSED_TABLEBASE_HEADER
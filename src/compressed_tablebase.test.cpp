@@ -0,0 +1,134 @@
+#include "./helper.h"
+#include "./test_fixtures.h"
+#include "./position_index.h"
+#include "./compressed_tablebase.h"
+#include <catch.hpp>
+#include <chess.hpp>
+#include <filesystem>
+#include <fstream>
+
+// Checks that tables survive the round trip through the compressed on-disk format, probing them
+// both through the shared block cache and by decompressing every block directly
+
+TEST_CASE("Compressed tables for kKR") {
+    auto const& tablebase = fixtures::generated_tablebase(6, 3, std::vector<char>{{'k', 'K', 'R'}});
+    auto const dense_tables = tablebase::dense_tables_from_tablebase(tablebase, 6);
+
+    auto const directory = std::filesystem::temp_directory_path() / "comp3821_compressed_tablebase_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    for (auto const& [signature, table] : dense_tables) {
+        // a small block size makes sure that lookups span many blocks
+        tablebase::write_compressed_table(table, (directory / (signature + tablebase::COMPRESSED_TABLE_EXTENSION)).string(), 256);
+    }
+
+    SECTION("Indexing round trips through FEN strings") {
+        auto const indexer = tablebase::PositionIndexer("kKR");
+        auto const FEN_string = std::string{"5k2/8/5K2/3R4/8/8/8/8 b - - 0 1"};
+        auto const index = indexer.index_of_FEN(FEN_string);
+
+        REQUIRE(index.has_value());
+        CHECK(indexer.FEN_at(*index) == FEN_string);
+        CHECK(indexer.index_of_board(chess::Board(FEN_string)) == index);
+        CHECK(not indexer.index_of_FEN("5k2/8/5K2/3Q4/8/8/8/8 b - - 0 1").has_value());
+    }
+
+    SECTION("Decompressed blocks match the dense table") {
+        auto const table = tablebase::CompressedTable((directory / "kKR.tbz").string());
+        auto const& expected = dense_tables.at("kKR").entries;
+
+        REQUIRE(table.size() == expected.size());
+        CHECK(table.compressed_size() < expected.size() / 4);
+
+        auto decompressed = tablebase::TableVector<std::uint8_t>{};
+        for (auto block = std::uint64_t{0}; block < table.num_blocks(); ++block) {
+            auto const entries = table.decompress_block(block);
+            decompressed.insert(decompressed.end(), entries.begin(), entries.end());
+        }
+        CHECK(decompressed == expected);
+    }
+
+    SECTION("Probes agree with the uncompressed tablebase") {
+        auto const compressed_tablebase = tablebase::CompressedTablebase(directory.string(), 16);
+
+        for (auto depth = 0; depth < static_cast<int>(tablebase.size()); ++depth) {
+            for (auto const& FEN_string : tablebase[depth]) {
+                REQUIRE(compressed_tablebase.get_depth_to_mate_for_state(FEN_string) == depth);
+            }
+        }
+
+        CHECK(compressed_tablebase.get_depth_to_mate_for_board(chess::Board("5k2/8/5K2/3R4/8/8/8/8 w - - 0 1")) == helper::get_depth_to_mate_for_state("5k2/8/5K2/3R4/8/8/8/8 w - - 0 1", tablebase));
+        CHECK(compressed_tablebase.get_depth_to_mate_for_state("8/8/8/3k4/8/8/8/K6R b - - 0 1") == -1);
+        CHECK(compressed_tablebase.cache().misses() > 0);
+        CHECK(compressed_tablebase.contains_signature("kKR"));
+        CHECK(not compressed_tablebase.contains_signature("kKQ"));
+    }
+
+    SECTION("Storing one side to move resolves the other side through its successors") {
+        auto const full_tablebase = tablebase::CompressedTablebase(directory.string());
+        auto const indexer = tablebase::PositionIndexer("kKR");
+
+        for (auto const stored_sides : {tablebase::StoredSides::WHITE_TO_MOVE, tablebase::StoredSides::BLACK_TO_MOVE}) {
+            auto const single_side_directory = directory / "single_side";
+            std::filesystem::remove_all(single_side_directory);
+            std::filesystem::create_directories(single_side_directory);
+            auto const single_side_size = tablebase::write_compressed_table(dense_tables.at("kKR"), (single_side_directory / "kKR.tbz").string(), 256, stored_sides);
+            CHECK(single_side_size < tablebase::CompressedTable((directory / "kKR.tbz").string()).compressed_size());
+
+            auto const single_side_tablebase = tablebase::CompressedTablebase(single_side_directory.string());
+            for (auto index = std::uint64_t{0}; index < indexer.size(); ++index) {
+                auto const FEN_string = indexer.FEN_at(index);
+                if (not FEN_string) continue;
+                auto const board = chess::Board(*FEN_string);
+                if (board.isAttacked(board.kingSq(~board.sideToMove()), board.sideToMove())) continue;
+
+                REQUIRE(single_side_tablebase.get_depth_to_mate_for_board(board) == full_tablebase.get_depth_to_mate_for_board(board));
+            }
+        }
+
+        CHECK(tablebase::choose_side_to_store(dense_tables.at("kKR")) != tablebase::StoredSides::BOTH);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Corrupt compressed blocks") {
+    auto const path = std::filesystem::temp_directory_path() / "comp3821_corrupt_block_test.tbz";
+    auto const size = tablebase::PositionIndexer("kK").size();
+    auto const table = tablebase::DenseTable{"kK", 6, tablebase::TableVector<std::uint8_t>(size, tablebase::NOT_A_FORCED_WIN)};
+
+    // a single block holding a single run, which ends with the run's length
+    tablebase::write_compressed_table(table, path.string(), static_cast<std::uint32_t>(size));
+    CHECK(tablebase::CompressedTable(path.string()).decompress_block(0).size() == size);
+
+    auto const overwrite_last_byte = [&path](char const byte) {
+        auto file = std::fstream(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-1, std::ios::end);
+        file.write(&byte, 1);
+    };
+
+    // a run length running past the end of the block
+    overwrite_last_byte('\x80');
+    CHECK_THROWS_AS(tablebase::CompressedTable(path.string()).decompress_block(0), std::runtime_error);
+
+    // a run which is too short for the block
+    overwrite_last_byte('\x01');
+    CHECK_THROWS_AS(tablebase::CompressedTable(path.string()).decompress_block(0), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Dense tables only store depths to mate which fit in a byte") {
+    auto const FEN_string = std::string{"3R1k2/8/5K2/8/8/8/8/8 b - - 0 1"};
+
+    auto forced_wins = std::vector<std::unordered_set<std::string>>(tablebase::MAX_STORED_DEPTH_TO_MATE + 1);
+    forced_wins.back().insert(FEN_string);
+    auto const tables = tablebase::dense_tables_from_tablebase(forced_wins, tablebase::MAX_STORED_DEPTH_TO_MATE);
+    auto const index = tablebase::PositionIndexer("kKR").index_of_FEN(FEN_string);
+    REQUIRE(index.has_value());
+    CHECK(tablebase::depth_to_mate_for_entry(tables.at("kKR").entries[*index]) == tablebase::MAX_STORED_DEPTH_TO_MATE);
+
+    forced_wins.emplace_back();
+    CHECK_THROWS_AS(tablebase::dense_tables_from_tablebase(forced_wins, tablebase::MAX_STORED_DEPTH_TO_MATE + 1), std::runtime_error);
+}
@@ -0,0 +1,142 @@
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <fstream>
+#include <stdexcept>
+#include <chess.hpp>
+#include "corpus.h"
+#include "position_index.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        auto is_counted(std::string const& signature, int const max_num_pieces) -> bool {
+            return static_cast<int>(signature.size()) <= max_num_pieces
+                and signature.find('p') == std::string::npos
+                and signature.find('P') == std::string::npos;
+        }
+
+        // Replays each game as soon as it has been parsed, counting the signature of every position
+        // once the game is down to few enough pieces
+        class SignatureCounter : public chess::pgn::Visitor {
+        public:
+            SignatureCounter(std::map<std::string, std::uint64_t>& histogram, int const max_num_pieces)
+                : histogram_{histogram}, max_num_pieces_{max_num_pieces} {}
+
+            void startPgn() override {
+                board_ = chess::Board();
+                skipped_ = false;
+            }
+
+            void header(std::string_view key, std::string_view value) override {
+                if (key == "FEN") {
+                    board_ = chess::Board(value);
+                } else if (key == "Variant" and value != "Standard" and value != "From Position") {
+                    skipped_ = true;
+                }
+            }
+
+            void startMoves() override {
+                if (not skipped_) count_position();
+            }
+
+            void move(std::string_view move, std::string_view comment) override {
+                if (skipped_) return;
+
+                try {
+                    movelist_.clear();
+                    auto const parsed_move = chess::uci::parseSan(board_, move, movelist_);
+                    if (parsed_move == chess::Move::NO_MOVE) {
+                        skipped_ = true;
+                        return;
+                    }
+                    board_.makeMove(parsed_move);
+                } catch (std::exception const&) {
+                    skipped_ = true;
+                    return;
+                }
+                count_position();
+            }
+
+            void endPgn() override {}
+
+        private:
+            auto count_position() -> void {
+                // checking the piece count first avoids building signatures for most positions
+                if (static_cast<int>(board_.occ().count()) > max_num_pieces_) return;
+
+                auto const signature = signature_of_board(board_);
+                if (is_counted(signature, max_num_pieces_)) {
+                    ++histogram_[signature];
+                }
+            }
+
+            std::map<std::string, std::uint64_t>& histogram_;
+            int max_num_pieces_;
+            chess::Board board_;
+            chess::Movelist movelist_;
+            bool skipped_ = false;
+        };
+    }
+
+
+    auto signature_histogram_of_corpus(std::string const& path, int const max_num_pieces) -> std::map<std::string, std::uint64_t> {
+        auto file = std::ifstream(path);
+        if (not file) {
+            throw std::runtime_error("Could not open corpus " + path);
+        }
+
+        auto histogram = std::map<std::string, std::uint64_t>{};
+
+        auto first_line = std::string{};
+        while (first_line.empty() and std::getline(file, first_line)) {}
+        if (first_line.starts_with("[")) {
+            file.clear();
+            file.seekg(0);
+
+            auto counter = SignatureCounter(histogram, max_num_pieces);
+            // the parser's read buffer is too large for the stack
+            auto parser = std::make_unique<chess::pgn::StreamParser<>>(file);
+            parser->readGames(counter);
+            return histogram;
+        }
+
+        for (auto line = first_line; ; ) {
+            if (not line.empty()) {
+                auto const signature = signature_of_FEN(line);
+                if (is_counted(signature, max_num_pieces)) {
+                    ++histogram[signature];
+                }
+            }
+            if (not std::getline(file, line)) break;
+        }
+        return histogram;
+    }
+
+    auto signatures_reachable_by_captures(std::string const& signature) -> std::set<std::string> {
+        auto reachable = std::set<std::string>{};
+        auto const non_king_pieces = signature.substr(2);
+        for (auto subset = 0u; subset < (1u << non_king_pieces.size()); ++subset) {
+            auto pieces = std::vector<char>{'k', 'K'};
+            for (auto i = std::size_t{0}; i < non_king_pieces.size(); ++i) {
+                if ((subset >> i) & 1u) {
+                    pieces.push_back(non_king_pieces[i]);
+                }
+            }
+            reachable.insert(signature_for_pieces(pieces));
+        }
+        return reachable;
+    }
+
+    auto signatures_required_for(std::vector<std::string> const& signatures) -> std::set<std::string> {
+        auto required = std::set<std::string>{};
+        for (auto const& signature : signatures) {
+            for (auto const& colour : {signature, colour_flipped_signature(signature)}) {
+                auto const reachable = signatures_reachable_by_captures(colour);
+                required.insert(reachable.begin(), reachable.end());
+            }
+        }
+        return required;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef COMP3821_PROJ_CORPUS_HEADER
+#define COMP3821_PROJ_CORPUS_HEADER
+
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <cstdint>
+
+namespace tablebase {
+    // Counts the signatures (see PositionIndexer) of every pawnless position with at most
+    // max_num_pieces pieces in a corpus, which is either a PGN file (detected by its first non-empty
+    // line starting with a '[' header) whose games are replayed move by move, or a file with one
+    // FEN string per line. Games with moves that cannot be parsed only count up to that move.
+    // Throws std::runtime_error if the file cannot be opened.
+    auto signature_histogram_of_corpus(std::string const& path, int const max_num_pieces) -> std::map<std::string, std::uint64_t>;
+
+    // The signature itself and every signature reachable from it by captures, i.e. kK along with
+    // each subset of its other pieces
+    auto signatures_reachable_by_captures(std::string const& signature) -> std::set<std::string>;
+
+    // Every signature that has to be solved for the given signatures to be fully resolved, i.e. the
+    // signatures themselves, their colour flips (as forced wins for black are stored as forced wins
+    // for white in the colour flipped signature) and every signature reachable from them by
+    // captures
+    auto signatures_required_for(std::vector<std::string> const& signatures) -> std::set<std::string>;
+}
+
+
+#endif // COMP3821_PROJ_CORPUS_HEADER
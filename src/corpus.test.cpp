@@ -0,0 +1,38 @@
+#include "./corpus.h"
+#include <catch.hpp>
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE("Signatures required by a corpus") {
+    auto const directory = std::filesystem::temp_directory_path() / "comp3821_corpus_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    SECTION("Games in a PGN file are replayed position by position") {
+        auto const path = (directory / "games.pgn").string();
+        auto pgn_file = std::ofstream(path);
+        pgn_file << "[Event \"Rook trade\"]\n[FEN \"4k3/8/8/8/8/8/3r4/R3K3 w - - 0 1\"]\n\n1. Ra2 Rxa2 1/2-1/2\n\n"
+            << "[Event \"Opening\"]\n\n1. e4 e5 2. Nf3 1/2-1/2\n";
+        pgn_file.close();
+
+        CHECK(tablebase::signature_histogram_of_corpus(path, 4) == std::map<std::string, std::uint64_t>{{"kKRr", 2}, {"kKr", 1}});
+        CHECK(tablebase::signature_histogram_of_corpus(path, 3) == std::map<std::string, std::uint64_t>{{"kKr", 1}});
+    }
+
+    SECTION("FEN files are counted line by line, skipping positions with pawns") {
+        auto const path = (directory / "positions.txt").string();
+        auto FEN_file = std::ofstream(path);
+        FEN_file << "8/8/8/3k4/8/8/3Q4/K7 w - - 0 1\n8/8/8/3k4/8/8/3Q4/K7 b - - 0 1\n\n"
+            << "4k3/4p3/8/8/8/8/8/4K3 w - - 0 1\n8/8/8/3k4/8/8/8/K7\n";
+        FEN_file.close();
+
+        CHECK(tablebase::signature_histogram_of_corpus(path, 5) == std::map<std::string, std::uint64_t>{{"kKQ", 2}, {"kK", 1}});
+    }
+
+    SECTION("Colour flips and captures are required") {
+        CHECK(tablebase::signatures_required_for({"kKRn"}) == std::set<std::string>{"kK", "kKN", "kKNr", "kKR", "kKRn", "kKn", "kKr"});
+        CHECK(tablebase::signatures_required_for({"kKQ", "kKq"}) == std::set<std::string>{"kK", "kKQ", "kKq"});
+    }
+
+    std::filesystem::remove_all(directory);
+}
@@ -1,4 +1,5 @@
 #include "./helper.h"
+#include "./test_fixtures.h"
 #include <catch.hpp>
 #include <chess.hpp>
 #include <set>
@@ -11,10 +12,10 @@
 
 
 
-// These tests may take a few minutes to run due to the significant number of board states generated
-// during checkmate generation for the tablebase
+// Generating these tablebases takes minutes due to the significant number of board states generated
+// during checkmate generation, so each one is generated once and shared (see test_fixtures.h)
 TEST_CASE("Three piece endgames with kKQ") {
-    auto const tablebase = helper::definitive_generate_tablebase(10, 3, std::vector<char>{{'k', 'K', 'Q'}});
+    auto const& tablebase = fixtures::generated_tablebase(10, 3, std::vector<char>{{'k', 'K', 'Q'}});
 
     SECTION("Mate in 1, no captures") {
         auto const FEN_string = "4k3/Q7/5K2/8/8/8/8/8 w - - 0 1";
@@ -43,7 +44,7 @@ TEST_CASE("Three piece endgames with kKQ") {
 }
 
 TEST_CASE("Other three piece endgames") {
-    auto const tablebase = helper::definitive_generate_tablebase(10, 3, std::vector<char>{});
+    auto const& tablebase = fixtures::generated_tablebase(10, 3, std::vector<char>{});
 
     SECTION("Mate in 5 with kKR") {
         auto const FEN_string = "5k2/8/8/3R1K2/8/8/8/8 w - - 0 1";
@@ -80,16 +81,14 @@ TEST_CASE("Other three piece endgames") {
 
 
 struct Fixture {
-    Fixture() {
-        // A fixture is required to reuse/memoise the result from this tablebase generation
-        tablebase = helper::definitive_generate_tablebase(5, 4, std::vector<char>{{'k', 'K', 'Q', 'n'}});
-    }
-
-    std::vector<std::unordered_set<std::string>> tablebase;
+    // Catch constructs the fixture again for every section, so the tablebase itself is memoised
+    std::vector<std::unordered_set<std::string>> const& tablebase = fixtures::generated_tablebase(5, 4, std::vector<char>{{'k', 'K', 'Q', 'n'}});
 };
 
 
-TEST_CASE_METHOD(Fixture, "Four piece endgame for kKQn") {
+// Generating kKQn takes around 100s without a cached fixture, so these only run when asked for
+// (see FOUR_PIECE_TESTS in CMakeLists.txt)
+TEST_CASE_METHOD(Fixture, "Four piece endgame for kKQn", "[.][four_pieces]") {
     SECTION("Mate in 2 with kKQn without capture") {
         auto const FEN_string = "6k1/8/5K2/8/1n6/7Q/8/8 w - - 0 1";
 
@@ -115,4 +114,63 @@ TEST_CASE_METHOD(Fixture, "Four piece endgame for kKQn") {
 
         CHECK(result == expected_result);
     }
+
+    SECTION("Mate in 1 with kKQn") {
+        auto const FEN_string = "6k1/8/7K/7Q/8/3n4/8/8 w - - 0 1";
+
+        auto const expected_result = std::set<std::string>{{
+            std::string{"4Q1k1/8/7K/8/8/3n4/8/8 b - - 0 1"}
+        }};
+
+        auto const result = helper::definitive_get_next_move(FEN_string, tablebase);
+
+        CHECK(result == expected_result);
+    }
+
+    SECTION("Mate in 3 with kKQn by moving the queen out of the knight's reach") {
+        auto const FEN_string = "5k2/8/4K3/8/4Q2n/8/8/8 w - - 0 1";
+
+        auto const expected_result = std::set<std::string>{{
+            std::string{"5k2/7Q/4K3/8/7n/8/8/8 b - - 0 1"}
+        }};
+
+        auto const result = helper::definitive_get_next_move(FEN_string, tablebase);
+
+        CHECK(result == expected_result);
+    }
+
+    SECTION("Mate in 3 with kKQn by capturing the enemy knight with the king") {
+        auto const FEN_string = "8/8/8/8/2K5/1n6/6Q1/1k6 w - - 0 1";
+
+        auto const expected_result = std::set<std::string>{{
+            std::string{"8/8/8/8/8/1K6/6Q1/1k6 b - - 0 1"}
+        }};
+
+        auto const result = helper::definitive_get_next_move(FEN_string, tablebase);
+
+        CHECK(result == expected_result);
+    }
+
+    SECTION("Mate in 5 with kKQn, with and without capturing the enemy knight") {
+        auto const FEN_string = "k7/2Q5/2K5/4n3/8/8/8/8 w - - 0 1";
+
+        auto const expected_result = std::set<std::string>{{
+            std::string{"k7/2Q5/1K6/4n3/8/8/8/8 b - - 0 1"},
+            std::string{"k7/8/2K5/4Q3/8/8/8/8 b - - 0 1"}
+        }};
+
+        auto const result = helper::definitive_get_next_move(FEN_string, tablebase);
+
+        CHECK(result == expected_result);
+    }
+
+    SECTION("No forced wins within 5 moves for kKQn") {
+        auto const FEN_string = "1n6/3K4/Q7/8/8/7k/8/8 w - - 0 1";
+
+        auto const expected_result = std::set<std::string>{};
+
+        auto const result = helper::definitive_get_next_move(FEN_string, tablebase);
+
+        CHECK(result == expected_result);
+    }
 }
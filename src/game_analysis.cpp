@@ -0,0 +1,178 @@
+#include <vector>
+#include <string>
+#include <optional>
+#include <sstream>
+#include <exception>
+#include "game_analysis.h"
+#include "position_index.h"
+
+namespace tablebase {
+    GameCollector::GameCollector(std::function<void(Game)> on_game) : on_game_{std::move(on_game)} {}
+
+    void GameCollector::startPgn() {
+        current_ = Game{num_games_++, std::string{chess::constants::STARTPOS}, false, {}};
+    }
+
+    void GameCollector::header(std::string_view key, std::string_view value) {
+        if (key == "FEN") {
+            current_.starting_FEN = std::string{value};
+        } else if (key == "Variant" and value != "Standard" and value != "From Position") {
+            // castling and move legality differ in other variants
+            current_.skipped = true;
+            skipPgn(true);
+        }
+    }
+
+    void GameCollector::startMoves() {}
+
+    void GameCollector::move(std::string_view move, std::string_view comment) {
+        // games without moves may still report their comment
+        if (move.empty()) return;
+        current_.moves.emplace_back(move);
+    }
+
+    void GameCollector::endPgn() {
+        on_game_(std::move(current_));
+    }
+
+    auto GameCollector::num_games() const -> std::uint64_t {
+        return num_games_;
+    }
+
+    auto to_string(Grade const grade) -> std::string {
+        switch (grade) {
+            case Grade::OPTIMAL: return "optimal";
+            case Grade::SUBOPTIMAL: return "suboptimal";
+            case Grade::WIN_THROWN_AWAY: return "win_thrown_away";
+            case Grade::BLUNDER: return "blunder";
+            default: return "unknown";
+        }
+    }
+
+    auto probe_position(CompressedTablebase const& compressed_tablebase, chess::Board const& board) -> Probe {
+        auto const signature = signature_of_board(board);
+        if (
+            not compressed_tablebase.contains_signature(signature) or
+            not compressed_tablebase.contains_signature(colour_flipped_signature(signature))
+        ) {
+            return Probe{false, signature, -1, -1};
+        }
+
+        // castling rights and move counters are dropped, as positions in the tables have neither
+        auto const full_FEN = board.getFen(false);
+        auto const FEN_string = full_FEN.substr(0, full_FEN.find(' '))
+            + ((board.sideToMove() == chess::Color::WHITE) ? " w - - 0 1" : " b - - 0 1");
+
+        return Probe{
+            true,
+            signature,
+            compressed_tablebase.get_depth_to_mate_for_state(FEN_string),
+            compressed_tablebase.get_depth_to_mate_for_state(colour_flipped_FEN(FEN_string)),
+        };
+    }
+
+    auto grade_move(Probe const& before, Probe const& after, bool const isWhiteTurn) -> Grade {
+        if (not after.covered) return Grade::UNKNOWN;
+
+        auto const mover_depth_before = isWhiteTurn ? before.white_depth_to_mate : before.black_depth_to_mate;
+        auto const opponent_depth_before = isWhiteTurn ? before.black_depth_to_mate : before.white_depth_to_mate;
+        auto const mover_depth_after = isWhiteTurn ? after.white_depth_to_mate : after.black_depth_to_mate;
+        auto const opponent_depth_after = isWhiteTurn ? after.black_depth_to_mate : after.white_depth_to_mate;
+
+        if (mover_depth_before >= 0) {
+            if (mover_depth_after == mover_depth_before - 1) return Grade::OPTIMAL;
+            return (mover_depth_after >= 0) ? Grade::SUBOPTIMAL : Grade::WIN_THROWN_AWAY;
+        }
+        if (opponent_depth_before >= 0) {
+            return (opponent_depth_after == opponent_depth_before - 1) ? Grade::OPTIMAL : Grade::SUBOPTIMAL;
+        }
+        return (opponent_depth_after >= 0) ? Grade::BLUNDER : Grade::OPTIMAL;
+    }
+
+    auto SignatureStats::merge(SignatureStats const& other) -> void {
+        positions += other.positions;
+        forced_wins += other.forced_wins;
+        forced_losses += other.forced_losses;
+        for (auto const& [grade, count] : other.grades) {
+            grades[grade] += count;
+        }
+    }
+
+    auto AnalysisResult::merge(AnalysisResult const& other) -> void {
+        games += other.games;
+        moves_replayed += other.moves_replayed;
+        unparsable_games += other.unparsable_games;
+        for (auto const& [signature, signature_stats] : other.stats) {
+            stats[signature].merge(signature_stats);
+        }
+    }
+
+    auto analyze_game(
+        CompressedTablebase const& compressed_tablebase,
+        int const max_pieces_covered,
+        Game const& game,
+        AnalysisResult& result,
+        std::string* csv_rows
+    ) -> void {
+        ++result.games;
+        if (game.skipped) return;
+
+        auto board = chess::Board(game.starting_FEN);
+        auto movelist = chess::Movelist();
+        // the probe of the current position, carried over from grading the previous move
+        auto current_probe = std::optional<Probe>{};
+
+        for (auto ply = std::size_t{0}; ply < game.moves.size(); ++ply) {
+            auto move = chess::Move{};
+            try {
+                movelist.clear();
+                move = chess::uci::parseSan(board, game.moves[ply], movelist);
+            } catch (std::exception const&) {
+                ++result.unparsable_games;
+                return;
+            }
+            if (move == chess::Move::NO_MOVE) {
+                ++result.unparsable_games;
+                return;
+            }
+            ++result.moves_replayed;
+
+            // captures are irreversible, so once a game is down to few enough pieces every
+            // remaining position is probed, while positions before then are skipped cheaply
+            auto const covered = board.occ().count() <= max_pieces_covered and board.pieces(chess::PieceType::PAWN).empty();
+            if (not covered) {
+                board.makeMove(move);
+                continue;
+            }
+
+            auto const isWhiteTurn = board.sideToMove() == chess::Color::WHITE;
+            auto const before = current_probe ? std::move(*current_probe) : probe_position(compressed_tablebase, board);
+            auto const FEN_before = (csv_rows != nullptr) ? board.getFen() : std::string{};
+            board.makeMove(move);
+            current_probe.reset();
+            if (not before.covered) continue;
+
+            auto after = probe_position(compressed_tablebase, board);
+            auto const grade = grade_move(before, after, isWhiteTurn);
+
+            auto const mover_depth = isWhiteTurn ? before.white_depth_to_mate : before.black_depth_to_mate;
+            auto const opponent_depth = isWhiteTurn ? before.black_depth_to_mate : before.white_depth_to_mate;
+            auto& stats = result.stats[before.signature];
+            ++stats.positions;
+            stats.forced_wins += (mover_depth >= 0);
+            stats.forced_losses += (opponent_depth >= 0);
+            ++stats.grades[grade];
+
+            if (csv_rows != nullptr) {
+                auto row = std::stringstream{};
+                row << game.number << "," << ply << "," << FEN_before << "," << game.moves[ply] << ","
+                    << before.signature << ","
+                    << ((mover_depth >= 0) ? "win" : ((opponent_depth >= 0) ? "loss" : "no_forced_win")) << ","
+                    << ((mover_depth >= 0) ? mover_depth : opponent_depth) << "," << to_string(grade) << "\n";
+                csv_rows->append(row.str());
+            }
+
+            current_probe = std::move(after);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef COMP3821_PROJ_GAME_ANALYSIS_HEADER
+#define COMP3821_PROJ_GAME_ANALYSIS_HEADER
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <map>
+#include <functional>
+#include <cstdint>
+#include <chess.hpp>
+#include "compressed_tablebase.h"
+
+namespace tablebase {
+    // A game read from a PGN file, with its moves in SAN
+    struct Game {
+        std::uint64_t number;
+        std::string starting_FEN;
+        // games of variants other than standard chess are not analysed
+        bool skipped;
+        std::vector<std::string> moves;
+    };
+
+    // Collects the games streamed by chess::pgn::StreamParser, handing each one over as it ends.
+    // The rest of a skipped game is skipped by the parser, so its moves are never buffered.
+    class GameCollector : public chess::pgn::Visitor {
+    public:
+        explicit GameCollector(std::function<void(Game)> on_game);
+
+        void startPgn() override;
+        void header(std::string_view key, std::string_view value) override;
+        void startMoves() override;
+        void move(std::string_view move, std::string_view comment) override;
+        void endPgn() override;
+
+        auto num_games() const -> std::uint64_t;
+
+    private:
+        std::function<void(Game)> on_game_;
+        Game current_;
+        std::uint64_t num_games_ = 0;
+    };
+
+    // How a played move compares to the tablebase's verdict on the position it was played from
+    enum class Grade {
+        // keeps the quickest forced win, delays a forced loss the longest, or (without any forced
+        // win for either player) does not hand the opponent a forced win
+        OPTIMAL,
+        // a forced win is kept, or a forced loss is accepted, but not in the fewest/most moves
+        SUBOPTIMAL,
+        // the player to move had a forced win and no longer does after the move
+        WIN_THROWN_AWAY,
+        // neither player had a forced win, but the opponent has one after the move
+        BLUNDER,
+        // the position after the move (e.g. after a capture) has a signature without a table
+        UNKNOWN,
+    };
+
+    auto to_string(Grade const grade) -> std::string;
+
+    // Depths to mate for both players in a position (-1 where a player has no forced win)
+    struct Probe {
+        bool covered;
+        std::string signature;
+        int white_depth_to_mate;
+        int black_depth_to_mate;
+    };
+
+    // Our tables only hold forced wins for white, so forced wins for black are found by probing
+    // the colour flipped position (which needs the colour flipped signature to have a table)
+    auto probe_position(CompressedTablebase const& compressed_tablebase, chess::Board const& board) -> Probe;
+
+    auto grade_move(Probe const& before, Probe const& after, bool const isWhiteTurn) -> Grade;
+
+    struct SignatureStats {
+        std::uint64_t positions = 0;
+        std::uint64_t forced_wins = 0;
+        std::uint64_t forced_losses = 0;
+        std::map<Grade, std::uint64_t> grades;
+
+        auto merge(SignatureStats const& other) -> void;
+    };
+
+    struct AnalysisResult {
+        std::uint64_t games = 0;
+        std::uint64_t moves_replayed = 0;
+        std::uint64_t unparsable_games = 0;
+        std::map<std::string, SignatureStats> stats;
+
+        auto merge(AnalysisResult const& other) -> void;
+    };
+
+    // Replays a game, grading every move played from a position covered by the tables (at most
+    // max_pieces_covered pieces and no pawns). Rows for the CSV output of tb_analyze (if any) are
+    // appended to csv_rows. Skipped games only count towards the number of games.
+    auto analyze_game(
+        CompressedTablebase const& compressed_tablebase,
+        int const max_pieces_covered,
+        Game const& game,
+        AnalysisResult& result,
+        std::string* csv_rows = nullptr
+    ) -> void;
+}
+
+
+#endif // COMP3821_PROJ_GAME_ANALYSIS_HEADER
@@ -0,0 +1,92 @@
+#include "./bitbase_solver.h"
+#include "./compressed_tablebase.h"
+#include "./game_analysis.h"
+#include <catch.hpp>
+#include <chess.hpp>
+#include <filesystem>
+#include <sstream>
+#include <memory>
+
+namespace {
+    // The grade of every graded move, read back from the CSV rows of the game
+    auto grades_of_game(tablebase::CompressedTablebase const& compressed_tablebase, tablebase::Game const& game) -> std::vector<std::string> {
+        auto result = tablebase::AnalysisResult{};
+        auto csv_rows = std::string{};
+        tablebase::analyze_game(compressed_tablebase, 3, game, result, &csv_rows);
+
+        auto grades = std::vector<std::string>{};
+        auto rows = std::istringstream{csv_rows};
+        for (auto row = std::string{}; std::getline(rows, row);) {
+            grades.emplace_back(row.substr(row.rfind(',') + 1));
+        }
+        return grades;
+    }
+}
+
+TEST_CASE("Grading the moves of games against compressed tables") {
+    auto const dense_tables = tablebase::solve_signatures_with_bitboards({"kK", "kKQ", "kKq"}, 30);
+
+    auto const directory = std::filesystem::temp_directory_path() / "comp3821_game_analysis_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    for (auto const& [signature, table] : dense_tables) {
+        tablebase::write_compressed_table(table, (directory / (signature + tablebase::COMPRESSED_TABLE_EXTENSION)).string());
+    }
+    auto const compressed_tablebase = tablebase::CompressedTablebase(directory.string());
+
+    auto pgn = std::istringstream{
+        "[FEN \"k7/8/1K6/8/8/8/8/2Q5 w - - 0 1\"]\n[SetUp \"1\"]\n\n1. Qc8# 1-0\n\n"
+        "[FEN \"k7/8/1K6/8/8/8/8/2Q5 w - - 0 1\"]\n[SetUp \"1\"]\n\n1. Qc7 1/2-1/2\n\n"
+        "[FEN \"k7/8/1K6/8/8/8/8/2Q5 w - - 0 1\"]\n[SetUp \"1\"]\n\n1. Qc2 Kb8 *\n\n"
+        "[FEN \"7K/8/8/8/8/1Qk5/8/8 b - - 0 1\"]\n[SetUp \"1\"]\n\n1... Kxb3 1/2-1/2\n\n"
+        "[FEN \"7K/8/8/8/8/1Qk5/8/8 b - - 0 1\"]\n[SetUp \"1\"]\n\n1... Kd4 *\n\n"
+        "[Variant \"Chess960\"]\n[FEN \"k7/8/1K6/8/8/8/8/2Q5 w - - 0 1\"]\n\n1. Qc7 Kb8 *\n\n"
+    };
+    auto games = std::vector<tablebase::Game>{};
+    auto collector = tablebase::GameCollector([&games](tablebase::Game game) {
+        games.emplace_back(std::move(game));
+    });
+    // the parser's read buffer is too large for the stack
+    auto parser = std::make_unique<chess::pgn::StreamParser<>>(pgn);
+    CHECK(not parser->readGames(collector).hasError());
+    REQUIRE(games.size() == 6);
+    CHECK(collector.num_games() == 6);
+
+    SECTION("Moves are graded against the depths to mate of both players") {
+        CHECK(grades_of_game(compressed_tablebase, games[0]) == std::vector<std::string>{"optimal"});
+        // stalemate
+        CHECK(grades_of_game(compressed_tablebase, games[1]) == std::vector<std::string>{"win_thrown_away"});
+        // a slower mate, then black delaying it the longest
+        auto const slower_mate = grades_of_game(compressed_tablebase, games[2]);
+        REQUIRE(slower_mate.size() == 2);
+        CHECK(slower_mate[0] == "suboptimal");
+        CHECK(slower_mate[1] == "optimal");
+        // taking the queen draws, while walking away from it loses
+        CHECK(grades_of_game(compressed_tablebase, games[3]) == std::vector<std::string>{"optimal"});
+        CHECK(grades_of_game(compressed_tablebase, games[4]) == std::vector<std::string>{"blunder"});
+    }
+
+    SECTION("Statistics are kept per signature") {
+        auto result = tablebase::AnalysisResult{};
+        for (auto const& game : games) {
+            tablebase::analyze_game(compressed_tablebase, 3, game, result);
+        }
+        CHECK(result.games == 6);
+        CHECK(result.unparsable_games == 0);
+
+        auto const& stats = result.stats.at("kKQ");
+        CHECK(stats.positions == 6);
+        CHECK(stats.grades.at(tablebase::Grade::OPTIMAL) == 3);
+        CHECK(stats.grades.at(tablebase::Grade::BLUNDER) == 1);
+    }
+
+    SECTION("Games of other variants are skipped without buffering their moves") {
+        CHECK(games[5].skipped);
+        CHECK(games[5].moves.empty());
+        CHECK(grades_of_game(compressed_tablebase, games[5]).empty());
+        CHECK(not games[0].skipped);
+        CHECK(games[2].moves == std::vector<std::string>{"Qc2", "Kb8"});
+    }
+
+    std::filesystem::remove_all(directory);
+}
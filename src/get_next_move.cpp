@@ -2,7 +2,14 @@
 #include <fstream>
 #include <chess.hpp>
 #include "helper.h"
+#include "position_index.h"
+#include "optimal_line.h"
 #include <map>
+#include <set>
+#include <optional>
+#include <utility>
+#include <algorithm>
+#include <unistd.h>
 
 auto convert_components_to_FEN(std::string& FEN_position, std::string& player_turn) -> std::string {
     auto res = FEN_position;
@@ -37,6 +44,54 @@ auto convert_piece_to_string = std::map<chess::Piece, std::string>({
     {chess::Piece::WHITEPAWN, "pawn"},
 });
 
+// Dense tables take a byte for every position of each signature with forced wins (e.g. 2GB for a 5
+// piece signature), so they are only built when every depth to mate fits in a byte and the tables
+// fit in half of the memory which is currently available
+auto dense_tables_fit_in_memory(std::vector<std::unordered_set<std::string>> const& states_with_forceable_wins_for_white) -> bool {
+    if (states_with_forceable_wins_for_white.size() > tablebase::MAX_STORED_DEPTH_TO_MATE + 1) return false;
+
+    auto signatures = std::set<std::string>{};
+    for (auto const& forced_wins : states_with_forceable_wins_for_white) {
+        for (auto const& FEN_string : forced_wins) {
+            signatures.insert(tablebase::signature_of_FEN(FEN_string));
+        }
+    }
+
+    auto table_bytes = std::uint64_t{0};
+    for (auto const& signature : signatures) {
+        table_bytes += tablebase::PositionIndexer(signature).size();
+    }
+    auto const available_pages = sysconf(_SC_AVPHYS_PAGES);
+    auto const page_size = sysconf(_SC_PAGE_SIZE);
+    if (available_pages <= 0 or page_size <= 0) return false;
+    return table_bytes <= static_cast<std::uint64_t>(available_pages) * static_cast<std::uint64_t>(page_size) / 2;
+}
+
+// Finds a move to a successor one ply closer to mate by probing the successors' FEN strings, for
+// tablebases too large to index
+auto next_move_from_FEN_strings(
+    std::string const& FEN_string,
+    std::vector<std::unordered_set<std::string>> const& states_with_forceable_wins_for_white
+) -> std::optional<std::pair<chess::Move, int>> {
+    auto const depth_to_mate = helper::get_depth_to_mate_for_state(FEN_string, states_with_forceable_wins_for_white);
+    if (depth_to_mate <= 0) return std::nullopt;
+
+    auto board = chess::Board(FEN_string);
+    auto movelist = chess::Movelist();
+    chess::movegen::legalmoves(movelist, board);
+
+    for (auto curr_move : movelist) {
+        board.makeMove(curr_move);
+        auto const successor_FEN = helper::board_to_FEN_wrapper(board);
+        board.unmakeMove(curr_move);
+
+        if (states_with_forceable_wins_for_white[depth_to_mate - 1].contains(successor_FEN)) {
+            return std::pair{curr_move, depth_to_mate};
+        }
+    }
+    return std::nullopt;
+}
+
 int main(void) {
     auto FEN_string = get_curr_board_FEN();
 
@@ -58,38 +113,62 @@ int main(void) {
         states_with_forceable_wins_for_white[depth_to_mate].emplace(curr_FEN);
     }
 
-    while (depth_to_mate = helper::get_depth_to_mate_for_state(FEN_string, states_with_forceable_wins_for_white)) {
-        if (depth_to_mate == -1) {
+    // the optimal lines are read from dense tables, which index positions without FEN strings
+    auto const use_dense_tables = dense_tables_fit_in_memory(states_with_forceable_wins_for_white);
+    auto tables = std::map<std::string, tablebase::DenseTable>{};
+    if (use_dense_tables) {
+        tables = tablebase::dense_tables_from_tablebase(
+            states_with_forceable_wins_for_white,
+            std::max(static_cast<int>(states_with_forceable_wins_for_white.size()) - 1, 0)
+        );
+    } else {
+        std::cout << "The tablebase is too large or too deep to index in memory, so only the next move is shown.\n";
+    }
+
+    while (true) {
+        auto line = std::vector<tablebase::OptimalPly>{};
+        if (use_dense_tables) {
+            line = tablebase::optimal_line(chess::Board(FEN_string), tables);
+        } else if (auto const next_move = next_move_from_FEN_strings(FEN_string, states_with_forceable_wins_for_white)) {
+            line.emplace_back(tablebase::OptimalPly{FEN_string, next_move->second, {next_move->first}});
+        }
+        if (line.empty() or line.front().optimal_moves.empty()) {
             std::cout << "There is no forced win for this board state according to our current "
                 << "endgame tablebase.\n";
             return 0;
         }
 
-        auto board = chess::Board(FEN_string);
-
-        auto movelist = chess::Movelist();
-        chess::movegen::legalmoves(movelist, board);
-
-        for (auto curr_move : movelist) {
-            auto successor_board = chess::Board(FEN_string);
-            successor_board.makeMove(curr_move);
-            auto successor_FEN = helper::board_to_FEN_wrapper(successor_board);
-
-            if (states_with_forceable_wins_for_white[depth_to_mate - 1].contains(successor_FEN)) {
-                std::cout << "Move the " << convert_piece_to_string[board.at(curr_move.from())]
-                    << " from " << curr_move.from() << " to " << curr_move.to() << ".\n";
-
-                if (depth_to_mate - 1 == 0) {
-                    std::cout << "Congrats for using this tablebase to checkmate.\n";
-                    return 0;
+        auto const board = chess::Board(FEN_string);
+        auto const curr_move = line.front().optimal_moves.front();
+        std::cout << "Move the " << convert_piece_to_string[board.at(curr_move.from())]
+            << " from " << curr_move.from() << " to " << curr_move.to() << ".\n";
+
+        // every ply of the line, with the moves that are equally good in brackets
+        if (use_dense_tables) {
+            std::cout << "Optimal line (mate in " << line.front().depth_to_mate << " plies):";
+            for (auto const& ply : line) {
+                if (ply.optimal_moves.empty()) break;
+                auto const ply_board = chess::Board(ply.FEN_string);
+                std::cout << " " << chess::uci::moveToSan(ply_board, ply.optimal_moves.front());
+                if (ply.optimal_moves.size() > 1) {
+                    std::cout << " (";
+                    for (auto i = std::size_t{1}; i < ply.optimal_moves.size(); ++i) {
+                        std::cout << (i > 1 ? " " : "") << chess::uci::moveToSan(ply_board, ply.optimal_moves[i]);
+                    }
+                    std::cout << ")";
                 }
-
-                std::cout << "\n\nNow wait for the opponent to take their own move, then continue.\n\n";
-
-                FEN_string = get_curr_board_FEN();
-                break;
             }
+            std::cout << "\n";
+        }
+
+        if (line.front().depth_to_mate - 1 == 0) {
+            std::cout << "Congrats for using this tablebase to checkmate.\n";
+            return 0;
         }
+
+        std::cout << "\n\nNow wait for the opponent to take their own move, then continue.\n\n";
+
+        FEN_string = get_curr_board_FEN();
     }
 
 
@@ -4,12 +4,18 @@
 
 #include <vector>
 #include <set>
+#include <map>
+#include <array>
+#include <bit>
+#include <cctype>
 #include <algorithm>
 #include <string>
 #include <chess.hpp>
 #include <unordered_set>
 #include <numeric>
 #include "helper.h"
+#include "position_index.h"
+#include "king_tables.h"
 
 namespace helper {
     // LIST OF ASSUMPTIONS USED IN OUR IMPLEMENTATION:
@@ -32,31 +38,6 @@ namespace helper {
             return prev == 'K' ? helper::PIECE_TYPES_WITHOUT_KINGS.begin() : helper::PIECE_TYPES_WITHOUT_KINGS.find(prev);
         }
 
-        // This performs the increment on the input vector, avoiding time spent copying
-        auto increment_enumerator(std::vector<uint8_t>& input) -> void {
-            auto iter = input.rbegin();
-            while ((++(*iter)) > NUM_BOARD_SQUARES - 1) {
-                *iter = 0;
-                ++iter;
-            }
-        }
-
-        // Determines if input enumerator value, when used to create a board, will result in missing
-        // pieces due to position overlap
-        auto contains_enumerator_overlaps(std::vector<uint8_t> input) -> bool {
-            std::sort(input.begin(), input.end());
-            auto i = input.begin();
-            auto j = ++(input.begin());
-
-            while (j != input.end()) {
-                if (*i == *j) return true;
-
-                ++i;
-                ++j;
-            }
-            return false;
-        }
-
         // Converts our array representation to a FEN string
         auto convert_array_to_FEN(
             std::array<char, NUM_BOARD_SQUARES> const& board,
@@ -109,6 +90,30 @@ namespace helper {
             return true;
         }
 
+        // Same as is_legal_board_state, but read straight from our array representation through the
+        // lookup tables of king_tables.h, which avoids constructing a board for every candidate
+        auto is_legal_board_array(std::array<char, NUM_BOARD_SQUARES> const& board, bool const isWhiteTurn) -> bool {
+            auto occupied = std::uint64_t{0};
+            auto king_square = -1;
+            auto const king_of_player_who_moved = isWhiteTurn ? 'k' : 'K';
+            for (auto index = 0; index < NUM_BOARD_SQUARES; ++index) {
+                if (board[index] == '\0') continue;
+                // array indices count ranks downwards from the 8th rank
+                auto const square = (7 - index / 8) * 8 + index % 8;
+                occupied |= std::uint64_t{1} << square;
+                if (board[index] == king_of_player_who_moved) king_square = square;
+            }
+
+            for (auto index = 0; index < NUM_BOARD_SQUARES; ++index) {
+                auto const piece = board[index];
+                if (piece == '\0' or static_cast<bool>(std::isupper(piece)) != isWhiteTurn) continue;
+                if (tablebase::attacks_king_square(piece, (7 - index / 8) * 8 + index % 8, king_square, occupied)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
         // Assuming that board state is legal, and current turn is black
         auto is_checkmate_win_for_white(chess::Board& board) -> bool {
             return board.inCheck() and (board.isGameOver().first == chess::GameResultReason::CHECKMATE);
@@ -216,18 +221,28 @@ namespace helper {
             return (static_cast<bool>(isupper(piece_type)) == isWhiteSide);
         }
 
-        auto perform_unmove_or_uncapture(
+        auto unmove_or_uncapture_array(
             std::array<char, NUM_BOARD_SQUARES> const& board_array_representation,
-            bool const isWhiteTurn,
             int const curr_index,
             int const predecessor_index,
             char const piece_type
-        ) -> std::string {
+        ) -> std::array<char, NUM_BOARD_SQUARES> {
             // char arrays are copied by value from what google says
             auto board_array_copy = board_array_representation;
             // do a swap where we move our piece from current location to new location
             board_array_copy[predecessor_index] = board_array_copy[curr_index];
             board_array_copy[curr_index] = piece_type;
+            return board_array_copy;
+        }
+
+        auto perform_unmove_or_uncapture(
+            std::array<char, NUM_BOARD_SQUARES> const& board_array_representation,
+            bool const isWhiteTurn,
+            int const curr_index,
+            int const predecessor_index,
+            char const piece_type
+        ) -> std::string {
+            auto const board_array_copy = unmove_or_uncapture_array(board_array_representation, curr_index, predecessor_index, piece_type);
             auto predecessor_FEN_string = convert_array_to_FEN(board_array_copy, isWhiteTurn);
             return predecessor_FEN_string;
         }
@@ -366,37 +381,72 @@ namespace helper {
 
     // Now, for a given set of pieces we want to generate all possible board states
     // We filter our boards for checkmates for white, and remove any illegal/underfilled states
+    // Since pawnless positions are equivalent under the 8 symmetries of the board, only the 462
+    // canonical king pairs are enumerated (see king_tables.h), and each checkmate found is added
+    // along with its symmetric images. Legality and check are decided through lookup tables, so
+    // a board is only constructed to confirm checkmate.
     auto generate_checkmates_for_piece_set_for_player(std::vector<char> const& pieces) -> std::vector<std::string> {
-        auto checkmates_for_player = std::vector<std::string>{};
-
-        // This lets us enumerate over the permutations of positions for each piece,
-        // the uint8s represent the position of the piece on the board, and the index in our
-        // enumerator correlates to its respective piece in the provided input vector of pieces
-        auto enumerator = std::vector<uint8_t>(pieces.size(), 0);
-        auto const max_enumerator_value = std::vector<uint8_t>(pieces.size(), NUM_BOARD_SQUARES - 1);
-        auto counter = 0;
-        // We can ignore the first and last cases for the enumerator because they are guaranteed to
-        // have overlaps, and thus are underfilled
-        while (enumerator != max_enumerator_value) {
-            counter++;
-            increment_enumerator(enumerator);
-            if (contains_enumerator_overlaps(enumerator)) {
-                continue;
-            }
+        auto checkmates_for_player = std::unordered_set<std::string>{};
 
-            auto board_array = std::array<char, NUM_BOARD_SQUARES>{};
-            for (auto i = 0; i < pieces.size(); ++i) {
-                board_array[enumerator[i]] = pieces[i];
+        // Assuming that both players have kings
+        auto const black_king = static_cast<std::size_t>(std::find(pieces.begin(), pieces.end(), 'k') - pieces.begin());
+        auto const white_king = static_cast<std::size_t>(std::find(pieces.begin(), pieces.end(), 'K') - pieces.begin());
+        auto other_pieces = std::vector<std::size_t>{};
+        for (auto i = std::size_t{0}; i < pieces.size(); ++i) {
+            if (i != black_king and i != white_king) {
+                other_pieces.push_back(i);
             }
+        }
 
-            auto const FEN_string = convert_array_to_FEN(board_array, false);
-            auto board_state = chess::Board(FEN_string);
-            if (is_legal_board_state(board_state) and is_checkmate_win_for_white(board_state)) {
-                checkmates_for_player.emplace_back(FEN_string);
+        // This lets us enumerate over the positions of the pieces other than the kings, where each
+        // of the 6 bit groups of the enumerator is the square of its respective piece
+        auto const num_enumerator_values = std::uint64_t{1} << (6 * other_pieces.size());
+        auto squares = std::vector<int>(pieces.size(), 0);
+        for (auto const& king_pair : tablebase::PAWNLESS_KING_PAIRS.pairs) {
+            squares[black_king] = king_pair.black_king;
+            squares[white_king] = king_pair.white_king;
+
+            for (auto enumerator = std::uint64_t{0}; enumerator < num_enumerator_values; ++enumerator) {
+                auto occupied = (std::uint64_t{1} << king_pair.black_king) | (std::uint64_t{1} << king_pair.white_king);
+                for (auto i = std::size_t{0}; i < other_pieces.size(); ++i) {
+                    auto const square = static_cast<int>((enumerator >> (6 * i)) & (NUM_BOARD_SQUARES - 1));
+                    squares[other_pieces[i]] = square;
+                    occupied |= std::uint64_t{1} << square;
+                }
+                // skip underfilled boards, due to position overlap
+                if (std::popcount(occupied) != static_cast<int>(pieces.size())) continue;
+
+                // the white king must be safe (as white just moved), and black must be in check
+                auto is_legal = true;
+                auto is_check = false;
+                for (auto i = std::size_t{0}; i < pieces.size(); ++i) {
+                    if (std::isupper(pieces[i])) {
+                        is_check = is_check or tablebase::attacks_king_square(pieces[i], squares[i], king_pair.black_king, occupied);
+                    } else {
+                        is_legal = is_legal and not tablebase::attacks_king_square(pieces[i], squares[i], king_pair.white_king, occupied);
+                    }
+                }
+                if (not is_legal or not is_check) continue;
+
+                auto board_array = std::array<char, NUM_BOARD_SQUARES>{};
+                for (auto i = std::size_t{0}; i < pieces.size(); ++i) {
+                    board_array[convert_square_to_index_for_array(chess::Square(squares[i]))] = pieces[i];
+                }
+                auto board_state = chess::Board(convert_array_to_FEN(board_array, false));
+                if (not is_checkmate_win_for_white(board_state)) continue;
+
+                for (auto symmetry = 0; symmetry < tablebase::NUM_SYMMETRIES; ++symmetry) {
+                    auto symmetric_board_array = std::array<char, NUM_BOARD_SQUARES>{};
+                    for (auto i = std::size_t{0}; i < pieces.size(); ++i) {
+                        auto const square = tablebase::transformed_square(squares[i], symmetry);
+                        symmetric_board_array[convert_square_to_index_for_array(chess::Square(square))] = pieces[i];
+                    }
+                    checkmates_for_player.emplace(convert_array_to_FEN(symmetric_board_array, false));
+                }
             }
         }
 
-        return checkmates_for_player;
+        return std::vector<std::string>{checkmates_for_player.begin(), checkmates_for_player.end()};
     }
 
     // Generates the direct predecessor board states for our current state, i.e. states where
@@ -404,12 +454,29 @@ namespace helper {
     auto generate_predecessor_board_states(
         std::string const& FEN_string,
         bool const isWhiteTurn,
-        int const max_pieces_present
+        int const max_pieces_present,
+        std::set<std::string> const* allowed_signatures
     ) -> std::unordered_set<std::string> {
         auto predecessor_board_states = std::unordered_set<std::string>{};
         auto const curr = chess::Board(FEN_string);
 
         auto const occupied_spaces_bitboard = curr.occ();
+
+        // the pieces which the player to move could have had captured in the previous move
+        auto uncapturable_piece_types = std::vector<char>{};
+        if (occupied_spaces_bitboard.count() < max_pieces_present) {
+            // only needed to restrict the uncaptures to the allowed signatures
+            auto const signature = (allowed_signatures != nullptr) ? tablebase::signature_of_board(curr) : std::string{};
+            for (auto piece_type : PIECE_TYPES_WITHOUT_KINGS) {
+                if (piece_type_belongs_to_player(piece_type, isWhiteTurn)) continue;
+                if (allowed_signatures != nullptr) {
+                    auto predecessor_pieces = std::vector<char>{signature.begin(), signature.end()};
+                    predecessor_pieces.push_back(piece_type);
+                    if (not allowed_signatures->contains(tablebase::signature_for_pieces(predecessor_pieces))) continue;
+                }
+                uncapturable_piece_types.push_back(piece_type);
+            }
+        }
         // bitboard of the player who just took a move, so we can find the squares of their pieces
         auto prev_turns_players_pieces_bitboard = curr.them(curr.sideToMove());
         auto const board_array_representation = convert_FEN_to_array(FEN_string);
@@ -436,22 +503,18 @@ namespace helper {
                 while (predecessor_locs_bitboard.count()) {
                     auto predecessor_index = convert_square_to_index_for_array(chess::Square(predecessor_locs_bitboard.pop()));
                     if (board_array_representation[predecessor_index] == '\0') {
-                        if (occupied_spaces_bitboard.count() < max_pieces_present) {
-                            for (auto piece_type : PIECE_TYPES_WITHOUT_KINGS) {
-                                if (not piece_type_belongs_to_player(piece_type, isWhiteTurn)) {
-                                    auto predecessor_FEN_string = perform_unmove_or_uncapture(board_array_representation, isWhiteTurn, curr_index, predecessor_index, piece_type);
-                                    auto predecessor_board = chess::Board(predecessor_FEN_string);
-                                    if (is_legal_board_state(predecessor_board)) {
-                                        predecessor_board_states.emplace(predecessor_FEN_string);
-                                    }
-                                }
+                        // legality is checked on the array, so only legal predecessors are
+                        // converted to FEN strings
+                        for (auto piece_type : uncapturable_piece_types) {
+                            auto const predecessor = unmove_or_uncapture_array(board_array_representation, curr_index, predecessor_index, piece_type);
+                            if (is_legal_board_array(predecessor, isWhiteTurn)) {
+                                predecessor_board_states.emplace(convert_array_to_FEN(predecessor, isWhiteTurn));
                             }
                         }
 
-                        auto const predecessor_FEN_string = perform_unmove_or_uncapture(board_array_representation, isWhiteTurn, curr_index, predecessor_index, '\0');
-                        auto predecessor_board = chess::Board(predecessor_FEN_string);
-                        if (is_legal_board_state(predecessor_board)) {
-                            predecessor_board_states.emplace(predecessor_FEN_string);
+                        auto const predecessor = unmove_or_uncapture_array(board_array_representation, curr_index, predecessor_index, '\0');
+                        if (is_legal_board_array(predecessor, isWhiteTurn)) {
+                            predecessor_board_states.emplace(convert_array_to_FEN(predecessor, isWhiteTurn));
                         }
                     }
                 }
@@ -603,6 +666,21 @@ namespace helper {
 
         return res;
     }
+
+    auto parse_command_line(int const argc, char const* const* const argv) -> CommandLine {
+        auto command_line = CommandLine{};
+        for (auto i = 1; i < argc; ++i) {
+            auto const argument = std::string{argv[i]};
+            if (argument.starts_with("--")) {
+                auto const equals_position = argument.find('=');
+                auto const name = argument.substr(2, equals_position - 2);
+                command_line.options[name] = (equals_position == std::string::npos) ? std::string{} : argument.substr(equals_position + 1);
+            } else {
+                command_line.positional_arguments.emplace_back(argument);
+            }
+        }
+        return command_line;
+    }
 }
 
 
@@ -6,6 +6,7 @@
 #include <chess.hpp>
 #include <unordered_set>
 #include <set>
+#include <map>
 
 namespace helper {
     // Utility function for printing boards to terminal, primarily was used during development for debugging
@@ -29,7 +30,14 @@ namespace helper {
 
     // Generates the direct predecessor board states for our current state, i.e. states where
     // a player takes one move to result in the current state (player turn matters)
-    auto generate_predecessor_board_states(std::string const& FEN_string, bool const isWhiteTurn, int const max_pieces_present) -> std::unordered_set<std::string>;
+    // If allowed_signatures is given, uncaptures are only generated where the predecessor's piece
+    // signature (see tablebase::signature_for_pieces) is in the set
+    auto generate_predecessor_board_states(
+        std::string const& FEN_string,
+        bool const isWhiteTurn,
+        int const max_pieces_present,
+        std::set<std::string> const* allowed_signatures = nullptr
+    ) -> std::unordered_set<std::string>;
 
     // Generates all successor board states to our input state (reached from taking a legal move)
     auto generate_successor_boards(std::string const& curr_FEN) -> std::unordered_set<std::string>;
@@ -57,6 +65,15 @@ namespace helper {
         std::string const& FEN_string,
         std::vector<std::unordered_set<std::string>> const& depth_to_mate_forced_wins_for_white
     ) -> std::set<std::string>;
+
+    // The arguments of one of our programs, where optional flags of the form --name=value (or
+    // just --name, which maps to an empty value) may be given alongside the positional arguments
+    struct CommandLine {
+        std::vector<std::string> positional_arguments;
+        std::map<std::string, std::string> options;
+    };
+
+    auto parse_command_line(int const argc, char const* const* const argv) -> CommandLine;
 }
 
 
@@ -0,0 +1,212 @@
+#ifndef COMP3821_PROJ_KING_TABLES_HEADER
+#define COMP3821_PROJ_KING_TABLES_HEADER
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+namespace tablebase {
+    // Lookup tables generated at compile time for the placement of kings and the attacks on them,
+    // which let the enumerator, retro-move generators and solvers rule out illegal positions without
+    // constructing a chess::Board. Squares use chess-library numbering (a1 = 0, h8 = 63).
+
+    // King pairs are the black king's square * 64 + the white king's square, i.e. the two squares
+    // directly after the side to move in the PositionIndexer layout (as every signature starts
+    // with "kK")
+    auto constexpr NUM_KING_PAIRS = 64 * 64;
+
+    // Squares reached from a square by repeated steps of (file_step, rank_step), stopping at the
+    // edge of the board, or after the first step if the piece does not slide
+    auto constexpr squares_in_direction(int const square, int const file_step, int const rank_step, bool const slides) -> std::uint64_t {
+        auto squares = std::uint64_t{0};
+        auto file = square % 8 + file_step;
+        auto rank = square / 8 + rank_step;
+        while (0 <= file and file < 8 and 0 <= rank and rank < 8) {
+            squares |= std::uint64_t{1} << (rank * 8 + file);
+            if (not slides) break;
+            file += file_step;
+            rank += rank_step;
+        }
+        return squares;
+    }
+
+    template <std::size_t N>
+    auto constexpr attack_table(std::array<std::array<int, 2>, N> const& steps, bool const slides) -> std::array<std::uint64_t, 64> {
+        auto table = std::array<std::uint64_t, 64>{};
+        for (auto square = 0; square < 64; ++square) {
+            for (auto const& [file_step, rank_step] : steps) {
+                table[static_cast<std::size_t>(square)] |= squares_in_direction(square, file_step, rank_step, slides);
+            }
+        }
+        return table;
+    }
+
+    auto constexpr ORTHOGONAL_STEPS = std::array<std::array<int, 2>, 4>{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+    auto constexpr DIAGONAL_STEPS = std::array<std::array<int, 2>, 4>{{{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+    auto constexpr KING_STEPS = std::array<std::array<int, 2>, 8>{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+    auto constexpr KNIGHT_STEPS = std::array<std::array<int, 2>, 8>{{{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}}};
+
+    // Attacks of each piece type on an empty board
+    inline auto constexpr KING_ATTACKS = attack_table(KING_STEPS, false);
+    inline auto constexpr KNIGHT_ATTACKS = attack_table(KNIGHT_STEPS, false);
+    inline auto constexpr BISHOP_ATTACKS = attack_table(DIAGONAL_STEPS, true);
+    inline auto constexpr ROOK_ATTACKS = attack_table(ORTHOGONAL_STEPS, true);
+    inline auto constexpr WHITE_PAWN_ATTACKS = attack_table(std::array<std::array<int, 2>, 2>{{{1, 1}, {-1, 1}}}, false);
+    inline auto constexpr BLACK_PAWN_ATTACKS = attack_table(std::array<std::array<int, 2>, 2>{{{1, -1}, {-1, -1}}}, false);
+
+    // Squares strictly between two squares on a shared rank, file or diagonal (and none otherwise)
+    auto constexpr squares_between_table() -> std::array<std::array<std::uint64_t, 64>, 64> {
+        auto table = std::array<std::array<std::uint64_t, 64>, 64>{};
+        for (auto from = 0; from < 64; ++from) {
+            for (auto const& [file_step, rank_step] : KING_STEPS) {
+                auto between = std::uint64_t{0};
+                auto file = from % 8 + file_step;
+                auto rank = from / 8 + rank_step;
+                while (0 <= file and file < 8 and 0 <= rank and rank < 8) {
+                    auto const to = rank * 8 + file;
+                    table[static_cast<std::size_t>(from)][static_cast<std::size_t>(to)] = between;
+                    between |= std::uint64_t{1} << to;
+                    file += file_step;
+                    rank += rank_step;
+                }
+            }
+        }
+        return table;
+    }
+
+    inline auto constexpr SQUARES_BETWEEN = squares_between_table();
+
+    // Squares attacked by a piece (given by its FEN character) on an empty board
+    auto constexpr empty_board_attacks(char const piece, int const square) -> std::uint64_t {
+        auto const index = static_cast<std::size_t>(square);
+        switch (piece) {
+            case 'K': case 'k': return KING_ATTACKS[index];
+            case 'N': case 'n': return KNIGHT_ATTACKS[index];
+            case 'B': case 'b': return BISHOP_ATTACKS[index];
+            case 'R': case 'r': return ROOK_ATTACKS[index];
+            case 'Q': case 'q': return BISHOP_ATTACKS[index] | ROOK_ATTACKS[index];
+            case 'P': return WHITE_PAWN_ATTACKS[index];
+            case 'p': return BLACK_PAWN_ATTACKS[index];
+            default: return 0;
+        }
+    }
+
+    // Whether a piece on one square attacks the king's square, given the occupied squares (only the
+    // squares between the two matter, so the king's own square may or may not be included)
+    auto constexpr attacks_king_square(char const piece, int const square, int const king_square, std::uint64_t const occupied) -> bool {
+        return ((empty_board_attacks(piece, square) >> king_square) & 1) != 0
+            and (SQUARES_BETWEEN[static_cast<std::size_t>(square)][static_cast<std::size_t>(king_square)] & occupied) == 0;
+    }
+
+    // Kings may never share or touch squares
+    auto constexpr are_legal_king_squares(int const black_king, int const white_king) -> bool {
+        return black_king != white_king and ((KING_ATTACKS[static_cast<std::size_t>(black_king)] >> white_king) & 1) == 0;
+    }
+
+    // The 8 symmetries of the board, where bit 0 mirrors the files, bit 1 mirrors the ranks and bit
+    // 2 swaps files with ranks (which is applied last). Without pawns (or castling) every symmetry
+    // maps positions onto equivalent positions, while with pawns only mirroring the files does.
+    auto constexpr NUM_SYMMETRIES = 8;
+
+    auto constexpr transformed_square(int const square, int const symmetry) -> int {
+        auto file = square % 8;
+        auto rank = square / 8;
+        if (symmetry & 1) file = 7 - file;
+        if (symmetry & 2) rank = 7 - rank;
+        return (symmetry & 4) ? file * 8 + rank : rank * 8 + file;
+    }
+
+    // Applies the inverse of transformed_square's symmetry
+    auto constexpr untransformed_square(int const square, int const symmetry) -> int {
+        auto const swapped = (symmetry & 4) ? (square % 8) * 8 + square / 8 : square;
+        auto file = swapped % 8;
+        auto rank = swapped / 8;
+        if (symmetry & 1) file = 7 - file;
+        if (symmetry & 2) rank = 7 - rank;
+        return rank * 8 + file;
+    }
+
+    struct KingPair {
+        std::int8_t black_king;
+        std::int8_t white_king;
+    };
+
+    // Where a king pair lies in a list of canonical king pairs, and the symmetry taking it there
+    // (index -1 for illegal king pairs)
+    struct KingPairClass {
+        std::int16_t index;
+        std::uint8_t symmetry;
+    };
+
+    // Canonical king pairs without pawns have the black king in the a1-d1-d4 triangle, and the
+    // white king on or below the a1-h8 diagonal whenever the black king is on it
+    auto constexpr is_canonical_pawnless_king_pair(int const black_king, int const white_king) -> bool {
+        auto const file = black_king % 8;
+        auto const rank = black_king / 8;
+        if (file > 3 or rank > file) return false;
+        return rank != file or white_king / 8 <= white_king % 8;
+    }
+
+    // Canonical king pairs with pawns have the black king on the a to d files
+    auto constexpr is_canonical_pawnful_king_pair(int const black_king, int const) -> bool {
+        return black_king % 8 <= 3;
+    }
+
+    auto constexpr NUM_PAWNLESS_KING_PAIRS = 462;
+    auto constexpr NUM_PAWNFUL_KING_PAIRS = 1806;
+
+    template <std::size_t N>
+    struct KingPairTables {
+        std::array<KingPair, N> pairs{};
+        std::array<KingPairClass, NUM_KING_PAIRS> classes{};
+    };
+
+    template <std::size_t N, typename IsCanonical>
+    auto constexpr king_pair_tables(IsCanonical const is_canonical, int const num_symmetries) -> KingPairTables<N> {
+        auto tables = KingPairTables<N>{};
+        auto canonical_indices = std::array<std::int16_t, NUM_KING_PAIRS>{};
+        auto count = std::size_t{0};
+        for (auto black_king = 0; black_king < 64; ++black_king) {
+            for (auto white_king = 0; white_king < 64; ++white_king) {
+                if (not are_legal_king_squares(black_king, white_king) or not is_canonical(black_king, white_king)) continue;
+                if (count == N) {
+                    throw std::logic_error("More canonical king pairs than expected");
+                }
+                canonical_indices[static_cast<std::size_t>(black_king * 64 + white_king)] = static_cast<std::int16_t>(count);
+                tables.pairs[count++] = KingPair{static_cast<std::int8_t>(black_king), static_cast<std::int8_t>(white_king)};
+            }
+        }
+        if (count != N) {
+            throw std::logic_error("Fewer canonical king pairs than expected");
+        }
+
+        for (auto king_pair = 0; king_pair < NUM_KING_PAIRS; ++king_pair) {
+            tables.classes[static_cast<std::size_t>(king_pair)] = KingPairClass{-1, 0};
+            auto const black_king = king_pair / 64;
+            auto const white_king = king_pair % 64;
+            if (not are_legal_king_squares(black_king, white_king)) continue;
+
+            for (auto symmetry = 0; symmetry < num_symmetries; ++symmetry) {
+                auto const canonical_black_king = transformed_square(black_king, symmetry);
+                auto const canonical_white_king = transformed_square(white_king, symmetry);
+                if (not is_canonical(canonical_black_king, canonical_white_king)) continue;
+
+                tables.classes[static_cast<std::size_t>(king_pair)] = KingPairClass{
+                    canonical_indices[static_cast<std::size_t>(canonical_black_king * 64 + canonical_white_king)],
+                    static_cast<std::uint8_t>(symmetry)
+                };
+                break;
+            }
+        }
+        return tables;
+    }
+
+    // Every canonical king pair (by black king, then white king) and the class of every king pair,
+    // where a king pair's canonical pair is its image under the class's symmetry. Generation fails
+    // to compile unless there are exactly 462 and 1806 canonical king pairs.
+    inline auto constexpr PAWNLESS_KING_PAIRS = king_pair_tables<NUM_PAWNLESS_KING_PAIRS>(is_canonical_pawnless_king_pair, NUM_SYMMETRIES);
+    inline auto constexpr PAWNFUL_KING_PAIRS = king_pair_tables<NUM_PAWNFUL_KING_PAIRS>(is_canonical_pawnful_king_pair, 2);
+}
+
+
+#endif // COMP3821_PROJ_KING_TABLES_HEADER
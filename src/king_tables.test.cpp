@@ -0,0 +1,58 @@
+#include "./king_tables.h"
+#include <catch.hpp>
+#include <chess.hpp>
+#include <random>
+
+TEST_CASE("King tables match chess-library's attacks") {
+    auto random = std::mt19937_64{3821};
+    for (auto square = 0; square < 64; ++square) {
+        auto const sq = chess::Square(square);
+        auto const index = static_cast<std::size_t>(square);
+        CHECK(tablebase::KING_ATTACKS[index] == chess::attacks::king(sq).getBits());
+        CHECK(tablebase::KNIGHT_ATTACKS[index] == chess::attacks::knight(sq).getBits());
+        CHECK(tablebase::BISHOP_ATTACKS[index] == chess::attacks::bishop(sq, 0).getBits());
+        CHECK(tablebase::ROOK_ATTACKS[index] == chess::attacks::rook(sq, 0).getBits());
+
+        for (auto trial = 0; trial < 16; ++trial) {
+            // sparse occupancies, so that slides are blocked only some of the time
+            auto const occupied = random() & random() & random();
+            for (auto king_square = 0; king_square < 64; ++king_square) {
+                auto const king_bit = std::uint64_t{1} << king_square;
+                CHECK(tablebase::attacks_king_square('q', square, king_square, occupied) == ((chess::attacks::queen(sq, occupied).getBits() & king_bit) != 0));
+                CHECK(tablebase::attacks_king_square('N', square, king_square, occupied) == ((chess::attacks::knight(sq).getBits() & king_bit) != 0));
+            }
+        }
+    }
+}
+
+TEST_CASE("Every legal king pair maps onto a canonical king pair") {
+    CHECK(tablebase::PAWNLESS_KING_PAIRS.pairs.size() == 462);
+    CHECK(tablebase::PAWNFUL_KING_PAIRS.pairs.size() == 1806);
+
+    auto num_legal_king_pairs = 0;
+    for (auto king_pair = 0; king_pair < tablebase::NUM_KING_PAIRS; ++king_pair) {
+        auto const black_king = king_pair / 64;
+        auto const white_king = king_pair % 64;
+        auto const is_legal = black_king != white_king and chess::Square::distance(chess::Square(black_king), chess::Square(white_king)) > 1;
+        CHECK(tablebase::are_legal_king_squares(black_king, white_king) == is_legal);
+        num_legal_king_pairs += is_legal;
+
+        for (auto const* tables : {&tablebase::PAWNLESS_KING_PAIRS.classes, &tablebase::PAWNFUL_KING_PAIRS.classes}) {
+            auto const king_pair_class = (*tables)[static_cast<std::size_t>(king_pair)];
+            CHECK((king_pair_class.index >= 0) == is_legal);
+            if (not is_legal) continue;
+
+            auto const symmetry = king_pair_class.symmetry;
+            auto const canonical = (tables == &tablebase::PAWNLESS_KING_PAIRS.classes)
+                ? tablebase::PAWNLESS_KING_PAIRS.pairs[static_cast<std::size_t>(king_pair_class.index)]
+                : tablebase::PAWNFUL_KING_PAIRS.pairs[static_cast<std::size_t>(king_pair_class.index)];
+            CHECK(canonical.black_king == tablebase::transformed_square(black_king, symmetry));
+            CHECK(canonical.white_king == tablebase::transformed_square(white_king, symmetry));
+            CHECK(tablebase::untransformed_square(canonical.black_king, symmetry) == black_king);
+            CHECK(tablebase::untransformed_square(canonical.white_king, symmetry) == white_king);
+        }
+        // pawns only allow mirroring the files
+        CHECK(tablebase::PAWNFUL_KING_PAIRS.classes[static_cast<std::size_t>(king_pair)].symmetry <= 1);
+    }
+    CHECK(num_legal_king_pairs == 3612);
+}
@@ -0,0 +1,166 @@
+#include <vector>
+#include <string>
+#include <array>
+#include <algorithm>
+#include "optimal_line.h"
+#include "helper.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        auto constexpr BITS_PER_SQUARE = 6;
+        auto constexpr MAX_PIECES = 8;
+
+        // A position's squares in signature order (as in PositionIndexer) along with its index,
+        // which is updated for each move instead of being recomputed from a board
+        struct TrackedPosition {
+            // nullptr when the position's signature has no table
+            DenseTable const* table = nullptr;
+            int num_pieces = 0;
+            std::array<int, MAX_PIECES> squares{};
+            std::uint64_t index = 0;
+        };
+
+        auto piece_shift(int const num_pieces, int const piece) -> int {
+            return BITS_PER_SQUARE * (num_pieces - 1 - piece);
+        }
+
+        auto black_to_move_bit(int const num_pieces) -> std::uint64_t {
+            return std::uint64_t{1} << (BITS_PER_SQUARE * num_pieces);
+        }
+
+        // Sorts identical pieces by ascending square and recomputes the index from scratch, which
+        // is only needed after captures or when a move changes the order of identical pieces
+        auto canonicalise(TrackedPosition& position, bool const isWhiteTurn) -> void {
+            auto const& signature = position.table->signature;
+            for (auto i = 1; i < position.num_pieces; ++i) {
+                for (auto j = i; j > 0 and signature[static_cast<std::size_t>(j)] == signature[static_cast<std::size_t>(j - 1)] and position.squares[static_cast<std::size_t>(j)] < position.squares[static_cast<std::size_t>(j - 1)]; --j) {
+                    std::swap(position.squares[static_cast<std::size_t>(j)], position.squares[static_cast<std::size_t>(j - 1)]);
+                }
+            }
+
+            position.index = isWhiteTurn ? 0 : 1;
+            for (auto i = 0; i < position.num_pieces; ++i) {
+                position.index = (position.index << BITS_PER_SQUARE) | static_cast<std::uint64_t>(position.squares[static_cast<std::size_t>(i)]);
+            }
+        }
+
+        auto track_board(chess::Board const& board, std::map<std::string, DenseTable> const& tables) -> TrackedPosition {
+            auto position = TrackedPosition{};
+            auto const table = tables.find(signature_of_board(board));
+            if (table == tables.end()) return position;
+
+            auto const indexer = PositionIndexer(table->first);
+            auto const index = indexer.index_of_board(board);
+            if (not index) return position;
+
+            position.table = &table->second;
+            position.num_pieces = indexer.num_pieces();
+            position.index = *index;
+            auto const squares = indexer.squares_at(*index);
+            std::copy(squares.begin(), squares.end(), position.squares.begin());
+            return position;
+        }
+
+        auto depth_to_mate_of_position(TrackedPosition const& position) -> int {
+            if (position.table == nullptr) return -1;
+            return depth_to_mate_for_entry(position.table->entries[position.index]);
+        }
+
+        auto position_after_move(
+            TrackedPosition const& position,
+            chess::Move const move,
+            std::map<std::string, DenseTable> const& tables
+        ) -> TrackedPosition {
+            auto const from = move.from().index();
+            auto const to = move.to().index();
+            auto const isWhiteTurn = (position.index & black_to_move_bit(position.num_pieces)) == 0;
+            auto const begin = position.squares.begin();
+            auto const end = begin + position.num_pieces;
+
+            auto successor = position;
+            auto const mover = static_cast<int>(std::find(begin, end, from) - begin);
+            auto const captured = static_cast<int>(std::find(begin, end, to) - begin);
+
+            if (captured == position.num_pieces) {
+                // only the moved piece's bits and the side to move change, unless the move takes
+                // the piece past an identical one
+                auto const shift = piece_shift(position.num_pieces, mover);
+                successor.squares[static_cast<std::size_t>(mover)] = to;
+                successor.index = ((position.index & ~(std::uint64_t{63} << shift)) | (static_cast<std::uint64_t>(to) << shift))
+                    ^ black_to_move_bit(position.num_pieces);
+
+                auto const& signature = position.table->signature;
+                auto const piece = signature[static_cast<std::size_t>(mover)];
+                auto const passes_previous = mover > 0 and signature[static_cast<std::size_t>(mover - 1)] == piece
+                    and successor.squares[static_cast<std::size_t>(mover - 1)] > to;
+                auto const passes_next = mover + 1 < position.num_pieces and signature[static_cast<std::size_t>(mover + 1)] == piece
+                    and successor.squares[static_cast<std::size_t>(mover + 1)] < to;
+                if (passes_previous or passes_next) {
+                    canonicalise(successor, not isWhiteTurn);
+                }
+                return successor;
+            }
+
+            // a capture moves into the table of the smaller signature (as the remaining pieces stay
+            // in signature order)
+            auto signature = position.table->signature;
+            signature.erase(static_cast<std::size_t>(captured), 1);
+            auto const table = tables.find(signature);
+            if (table == tables.end()) {
+                return TrackedPosition{};
+            }
+
+            successor.table = &table->second;
+            successor.num_pieces = position.num_pieces - 1;
+            successor.squares[static_cast<std::size_t>(mover)] = to;
+            std::copy(successor.squares.begin() + captured + 1, successor.squares.begin() + position.num_pieces, successor.squares.begin() + captured);
+            canonicalise(successor, not isWhiteTurn);
+            return successor;
+        }
+
+        auto optimal_moves_of_position(
+            chess::Board const& board,
+            TrackedPosition const& position,
+            std::map<std::string, DenseTable> const& tables
+        ) -> std::vector<chess::Move> {
+            auto res = std::vector<chess::Move>{};
+            auto const depth_to_mate = depth_to_mate_of_position(position);
+            if (depth_to_mate <= 0) return res;
+
+            auto movelist = chess::Movelist();
+            chess::movegen::legalmoves(movelist, board);
+            for (auto const curr_move : movelist) {
+                if (depth_to_mate_of_position(position_after_move(position, curr_move, tables)) == depth_to_mate - 1) {
+                    res.push_back(curr_move);
+                }
+            }
+            return res;
+        }
+    }
+
+
+    auto depth_to_mate_of_board(chess::Board const& board, std::map<std::string, DenseTable> const& tables) -> int {
+        return depth_to_mate_of_position(track_board(board, tables));
+    }
+
+    auto optimal_moves(chess::Board const& board, std::map<std::string, DenseTable> const& tables) -> std::vector<chess::Move> {
+        return optimal_moves_of_position(board, track_board(board, tables), tables);
+    }
+
+    auto optimal_line(chess::Board board, std::map<std::string, DenseTable> const& tables) -> std::vector<OptimalPly> {
+        auto line = std::vector<OptimalPly>{};
+        auto position = track_board(board, tables);
+        if (depth_to_mate_of_position(position) < 0) return line;
+
+        while (true) {
+            auto moves = optimal_moves_of_position(board, position, tables);
+            line.push_back(OptimalPly{helper::board_to_FEN_wrapper(board), depth_to_mate_of_position(position), moves});
+            if (moves.empty()) break;
+
+            position = position_after_move(position, moves.front(), tables);
+            board.makeMove(moves.front());
+        }
+        return line;
+    }
+}
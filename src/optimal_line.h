@@ -0,0 +1,37 @@
+#ifndef COMP3821_PROJ_OPTIMAL_LINE_HEADER
+#define COMP3821_PROJ_OPTIMAL_LINE_HEADER
+
+#include <vector>
+#include <string>
+#include <map>
+#include <chess.hpp>
+#include "position_index.h"
+
+namespace tablebase {
+    // One ply of an optimal line, i.e. a position along with its depth to mate and every move from
+    // it that keeps to an optimal line (in move generation order). White's optimal moves mate the
+    // quickest, while black's resist the longest, so both lead to a depth to mate one lower. The
+    // line continues with the first of them.
+    struct OptimalPly {
+        std::string FEN_string;
+        int depth_to_mate;
+        std::vector<chess::Move> optimal_moves;
+    };
+
+    // Finds the depth to mate of the board in the dense tables, or -1 if it is not a forced win
+    // for white (including when its signature has no table)
+    auto depth_to_mate_of_board(chess::Board const& board, std::map<std::string, DenseTable> const& tables) -> int;
+
+    // Every move from the board which keeps to an optimal line (empty if the board is not a forced
+    // win, or is checkmate). Each successor is looked up by updating the board's index for the
+    // move rather than making the move and indexing the resulting board.
+    auto optimal_moves(chess::Board const& board, std::map<std::string, DenseTable> const& tables) -> std::vector<chess::Move>;
+
+    // The optimal line from the board down to checkmate, with the alternatives at every ply (empty
+    // if the board is not a forced win). The tables of every signature reachable by captures along
+    // the line must be present, otherwise those captures are treated as escapes.
+    auto optimal_line(chess::Board board, std::map<std::string, DenseTable> const& tables) -> std::vector<OptimalPly>;
+}
+
+
+#endif // COMP3821_PROJ_OPTIMAL_LINE_HEADER
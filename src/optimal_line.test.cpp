@@ -0,0 +1,76 @@
+#include "./position_index.h"
+#include "./bitbase_solver.h"
+#include "./optimal_line.h"
+#include <catch.hpp>
+#include <chess.hpp>
+#include <algorithm>
+
+namespace {
+    // The optimal moves found by making each move and indexing the resulting board from scratch
+    auto optimal_moves_by_making_moves(chess::Board board, std::map<std::string, tablebase::DenseTable> const& tables) -> std::vector<chess::Move> {
+        auto res = std::vector<chess::Move>{};
+        auto const depth_to_mate = tablebase::depth_to_mate_of_board(board, tables);
+        if (depth_to_mate <= 0) return res;
+
+        auto movelist = chess::Movelist();
+        chess::movegen::legalmoves(movelist, board);
+        for (auto const curr_move : movelist) {
+            board.makeMove(curr_move);
+            auto const table = tables.find(tablebase::signature_of_board(board));
+            if (table != tables.end()) {
+                auto const index = tablebase::PositionIndexer(table->first).index_of_board(board);
+                if (tablebase::depth_to_mate_for_entry(table->second.entries[*index]) == depth_to_mate - 1) {
+                    res.push_back(curr_move);
+                }
+            }
+            board.unmakeMove(curr_move);
+        }
+        return res;
+    }
+}
+
+TEST_CASE("Optimal lines follow the tables down to checkmate") {
+    auto const tables = tablebase::solve_signatures_with_bitboards({"kK", "kKR", "kKn", "kKRR", "kKRn"}, 7);
+
+    SECTION("Updating indices per move matches indexing every successor") {
+        // identical pieces (kKRR) and captures into smaller tables (kKRn) both change the layout
+        for (auto const& signature : {"kKRR", "kKRn"}) {
+            auto const indexer = tablebase::PositionIndexer(signature);
+            auto const& table = tables.at(signature);
+            auto num_checked = 0;
+            for (auto index = std::uint64_t{0}; index < indexer.size(); index += 97) {
+                auto const FEN_string = indexer.FEN_at(index);
+                if (not FEN_string or table.entries[index] == tablebase::NOT_A_FORCED_WIN) continue;
+
+                auto const board = chess::Board(*FEN_string);
+                CHECK(tablebase::optimal_moves(board, tables) == optimal_moves_by_making_moves(board, tables));
+                ++num_checked;
+            }
+            CHECK(num_checked > 0);
+        }
+    }
+
+    SECTION("A line with alternatives") {
+        auto const FEN_string = "8/8/8/8/8/2K5/2R5/k7 w - - 0 1";
+        auto const line = tablebase::optimal_line(chess::Board(FEN_string), tables);
+
+        REQUIRE(line.size() == 6);
+        CHECK(line.front().FEN_string == FEN_string);
+        for (auto ply = std::size_t{0}; ply < line.size(); ++ply) {
+            CHECK(line[ply].depth_to_mate == static_cast<int>(line.size() - 1 - ply));
+            CHECK(line[ply].optimal_moves == optimal_moves_by_making_moves(chess::Board(line[ply].FEN_string), tables));
+        }
+
+        CHECK(std::any_of(line.begin(), line.end(), [](auto const& ply) { return ply.optimal_moves.size() > 1; }));
+
+        auto const mated = chess::Board(line.back().FEN_string);
+        CHECK(mated.isGameOver().first == chess::GameResultReason::CHECKMATE);
+        CHECK(line.back().optimal_moves.empty());
+    }
+
+    SECTION("Positions which are not forced wins have no line") {
+        CHECK(tablebase::optimal_line(chess::Board("5k2/8/5K2/2N5/8/8/8/8 b - - 0 1"), tables).empty());
+        CHECK(tablebase::optimal_line(chess::Board("5k2/8/5K2/2Q5/8/8/8/8 w - - 0 1"), tables).empty());
+        CHECK(tablebase::depth_to_mate_of_board(chess::Board("5k2/8/5K2/3R4/8/8/8/8 w - - 0 1"), tables) == 1);
+    }
+}
@@ -0,0 +1,163 @@
+#include <string>
+#include <stdexcept>
+#include <charconv>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include "output_writer.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        // Longest row: a depth to mate, the position segment of a FEN string (at most 71 characters),
+        // a turn and the separators
+        auto constexpr MAX_ROW_LENGTH = std::size_t{96};
+        // Appended to the output's path while it is being written
+        auto constexpr TEMPORARY_EXTENSION = ".tmp";
+
+        // Writes all of data at offset, as pwrite may write less than asked for
+        auto write_fully(int const file_descriptor, std::string_view data, std::uint64_t const offset, std::string const& path) -> void {
+            auto written = std::size_t{0};
+            while (written < data.size()) {
+                auto const result = pwrite(file_descriptor, data.data() + written, data.size() - written, static_cast<off_t>(offset + written));
+                if (result < 0) {
+                    if (errno == EINTR) continue;
+                    throw std::runtime_error("Failed while writing " + path + ": " + std::strerror(errno));
+                }
+                written += static_cast<std::size_t>(result);
+            }
+        }
+    }
+
+
+    OutputBuffer::OutputBuffer(std::string const& path, int const file_descriptor, std::uint64_t& offset, std::size_t const capacity)
+    : path_{path}
+    , file_descriptor_{file_descriptor}
+    , offset_{offset}
+    , capacity_{capacity} {
+        buffer_.reserve(capacity_ + MAX_ROW_LENGTH);
+    }
+
+    auto OutputBuffer::append_row(int const depth_to_mate, std::string_view const FEN_position_segment, char const player_turn) -> void {
+        auto digits = std::array<char, 16>{};
+        auto const end = std::to_chars(digits.data(), digits.data() + digits.size(), depth_to_mate).ptr;
+        buffer_.append(digits.data(), end);
+        buffer_.push_back(' ');
+        buffer_.append(FEN_position_segment);
+        buffer_.push_back(' ');
+        buffer_.push_back(player_turn);
+        buffer_.push_back('\n');
+
+        if (buffer_.size() >= capacity_) {
+            flush();
+        }
+    }
+
+    auto OutputBuffer::flush() -> void {
+        write_fully(file_descriptor_, buffer_, offset_, path_);
+        offset_ += buffer_.size();
+        buffer_.clear();
+    }
+
+
+    OutputWriter::OutputWriter(std::string const& path, std::size_t const buffer_size)
+    : path_{path}
+    , temporary_path_{path + TEMPORARY_EXTENSION}
+    , buffer_size_{buffer_size}
+    , file_descriptor_{open(temporary_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)} {
+        if (file_descriptor_ < 0) {
+            throw std::runtime_error("Unable to open " + temporary_path_ + " for writing");
+        }
+        thread_ = std::thread([this] { write_chunks(); });
+    }
+
+    OutputWriter::~OutputWriter() {
+        stop_writing();
+        if (not finished_) {
+            unlink(temporary_path_.c_str());
+        }
+    }
+
+    auto OutputWriter::write(Chunk chunk) -> void {
+        auto lock = std::unique_lock(mutex_);
+        not_full_.wait(lock, [this] { return chunks_.size() < MAX_QUEUED_OUTPUT_CHUNKS; });
+        chunks_.emplace_back(std::move(chunk));
+        not_empty_.notify_one();
+    }
+
+    auto OutputWriter::finish() -> std::uint64_t {
+        stop_writing();
+        if (not finished_ and not error_) {
+            if (rename(temporary_path_.c_str(), path_.c_str()) == 0) {
+                finished_ = true;
+            } else {
+                error_ = std::make_exception_ptr(std::runtime_error("Unable to move " + temporary_path_ + " to " + path_ + ": " + std::strerror(errno)));
+            }
+        }
+
+        if (error_) {
+            unlink(temporary_path_.c_str());
+            std::rethrow_exception(error_);
+        }
+        return offset_;
+    }
+
+    auto OutputWriter::stop_writing() -> void {
+        if (not thread_.joinable()) return;
+        {
+            auto lock = std::unique_lock(mutex_);
+            closed_ = true;
+            not_empty_.notify_all();
+        }
+        thread_.join();
+
+        if (close(file_descriptor_) != 0 and not error_) {
+            error_ = std::make_exception_ptr(std::runtime_error("Failed while writing " + temporary_path_));
+        }
+    }
+
+    auto OutputWriter::write_chunks() -> void {
+        while (true) {
+            auto chunk = Chunk{};
+            {
+                auto lock = std::unique_lock(mutex_);
+                not_empty_.wait(lock, [this] { return not chunks_.empty() or closed_; });
+                if (chunks_.empty()) return;
+                chunk = std::move(chunks_.front());
+                chunks_.pop_front();
+                not_full_.notify_one();
+            }
+
+            // the chunk is destroyed at the end of the iteration, freeing whatever it captured
+            if (error_) continue;
+            try {
+                auto buffer = OutputBuffer(path_, file_descriptor_, offset_, buffer_size_);
+                chunk(buffer);
+                buffer.flush();
+            } catch (...) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+
+    auto append_output_rows(OutputBuffer& buffer, int const depth_to_mate, std::unordered_set<std::string> const& FEN_strings) -> void {
+        for (auto const& FEN_string : FEN_strings) {
+            auto const separator = FEN_string.find(' ');
+            buffer.append_row(depth_to_mate, std::string_view(FEN_string).substr(0, separator), FEN_string[separator + 1]);
+        }
+    }
+
+    auto append_output_rows(OutputBuffer& buffer, DenseTable const& table) -> void {
+        auto const indexer = PositionIndexer(table.signature);
+        for (auto index = std::uint64_t{0}; index < table.entries.size(); ++index) {
+            if (table.entries[index] == NOT_A_FORCED_WIN) continue;
+
+            auto const FEN_string = indexer.FEN_at(index);
+            auto const FEN_position_segment = std::string_view(*FEN_string).substr(0, FEN_string->find(' '));
+            buffer.append_row(depth_to_mate_for_entry(table.entries[index]), FEN_position_segment, indexer.is_white_turn_at(index) ? 'w' : 'b');
+        }
+    }
+}
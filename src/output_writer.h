@@ -0,0 +1,97 @@
+#ifndef COMP3821_PROJ_OUTPUT_WRITER_HEADER
+#define COMP3821_PROJ_OUTPUT_WRITER_HEADER
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+#include "position_index.h"
+
+namespace tablebase {
+    // Rows are gathered into buffers of this many bytes, each written with a single pwrite
+    auto constexpr DEFAULT_OUTPUT_BUFFER_SIZE = std::size_t{8} << 20;
+    // Number of chunks the generator may run ahead of the writer before write blocks, which bounds
+    // the memory held by chunks waiting to be written
+    auto constexpr MAX_QUEUED_OUTPUT_CHUNKS = 4;
+
+    // Where a chunk's rows are serialised, which writes itself to the file whenever it fills up
+    class OutputBuffer {
+    public:
+        OutputBuffer(std::string const& path, int const file_descriptor, std::uint64_t& offset, std::size_t const capacity);
+
+        // Appends a row in the "depth_to_mate FEN_position_segment player_turn" format of output.csv
+        auto append_row(int const depth_to_mate, std::string_view const FEN_position_segment, char const player_turn) -> void;
+        auto flush() -> void;
+
+    private:
+        std::string const& path_;
+        int file_descriptor_;
+        std::uint64_t& offset_;
+        std::size_t capacity_;
+        std::string buffer_;
+    };
+
+    // Writes output.csv from a background thread, so that each completed ply (or signature) is
+    // serialised and written while the next one is being generated. Chunks are written in the order
+    // they are given, and whatever a chunk captures is freed as soon as it has been written.
+    // The rows go to a temporary file next to the output, which only replaces the output once
+    // finish succeeds, so a failed or abandoned run leaves any previous output as it was.
+    class OutputWriter {
+    public:
+        using Chunk = std::function<void(OutputBuffer&)>;
+
+        // Throws std::runtime_error if the temporary file cannot be opened
+        explicit OutputWriter(std::string const& path, std::size_t const buffer_size = DEFAULT_OUTPUT_BUFFER_SIZE);
+        // Discards the temporary file unless finish succeeded
+        ~OutputWriter();
+
+        OutputWriter(OutputWriter const&) = delete;
+        auto operator=(OutputWriter const&) -> OutputWriter& = delete;
+
+        // Blocks while MAX_QUEUED_OUTPUT_CHUNKS chunks are waiting to be written
+        auto write(Chunk chunk) -> void;
+
+        // Waits for every chunk to be written, closes the file and moves it to the output's path,
+        // returning the number of bytes written. Rethrows the first error of the writing thread
+        // (e.g. std::runtime_error when the disk is full), after which later chunks are skipped and
+        // the temporary file is discarded.
+        auto finish() -> std::uint64_t;
+
+    private:
+        // Waits for the writing thread and closes the file
+        auto stop_writing() -> void;
+        auto write_chunks() -> void;
+
+        std::string path_;
+        std::string temporary_path_;
+        std::size_t buffer_size_;
+        int file_descriptor_;
+        std::uint64_t offset_ = 0;
+        std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+        std::deque<Chunk> chunks_;
+        bool closed_ = false;
+        bool finished_ = false;
+        std::exception_ptr error_;
+        std::thread thread_;
+    };
+
+    // Serialises the positions of one ply of our FEN string generator, i.e. positions with a forced
+    // win in depth_to_mate plies
+    auto append_output_rows(OutputBuffer& buffer, int const depth_to_mate, std::unordered_set<std::string> const& FEN_strings) -> void;
+
+    // Serialises every forced win of a dense table, in index order
+    auto append_output_rows(OutputBuffer& buffer, DenseTable const& table) -> void;
+}
+
+
+#endif // COMP3821_PROJ_OUTPUT_WRITER_HEADER
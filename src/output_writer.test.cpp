@@ -0,0 +1,115 @@
+#include "./output_writer.h"
+#include "./bitbase_solver.h"
+#include <catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    auto read_file(std::filesystem::path const& path) -> std::string {
+        auto file = std::ifstream(path);
+        auto contents = std::stringstream{};
+        contents << file.rdbuf();
+        return contents.str();
+    }
+}
+
+TEST_CASE("Output rows are written in the background in the order they are given") {
+    auto const path = std::filesystem::temp_directory_path() / "comp3821_output_writer_test.csv";
+
+    auto const plies = std::vector<std::unordered_set<std::string>>{
+        {"3R1k2/8/5K2/8/8/8/8/8 b - - 0 1"},
+        {"5k2/8/5K2/3R4/8/8/8/8 w - - 0 1", "5k2/8/5K2/8/8/8/8/2R5 w - - 0 1"},
+    };
+    auto const tables = tablebase::solve_signatures_with_bitboards({"kK", "kKR"}, 4);
+    auto const& table = tables.at("kKR");
+
+    // the rows as written with std::ofstream before the writer existed
+    auto expected = std::stringstream{};
+    for (auto depth = 0; depth < static_cast<int>(plies.size()); ++depth) {
+        for (auto const& FEN_string : plies[static_cast<std::size_t>(depth)]) {
+            expected << depth << " " << FEN_string.substr(0, FEN_string.find(' ')) << " " << FEN_string[FEN_string.find(' ') + 1] << "\n";
+        }
+    }
+    auto const indexer = tablebase::PositionIndexer("kKR");
+    for (auto index = std::uint64_t{0}; index < table.entries.size(); ++index) {
+        if (table.entries[index] == tablebase::NOT_A_FORCED_WIN) continue;
+
+        auto const FEN_string = indexer.FEN_at(index);
+        expected << tablebase::depth_to_mate_for_entry(table.entries[index]) << " "
+            << FEN_string->substr(0, FEN_string->find(' ')) << " " << (indexer.is_white_turn_at(index) ? 'w' : 'b') << "\n";
+    }
+
+    // a tiny buffer makes every chunk take several writes
+    for (auto const buffer_size : {std::size_t{64}, tablebase::DEFAULT_OUTPUT_BUFFER_SIZE}) {
+        auto writer = tablebase::OutputWriter(path.string(), buffer_size);
+        for (auto depth = std::size_t{0}; depth < plies.size(); ++depth) {
+            // chunks may own what they write
+            writer.write([depth, ply = plies[depth]](tablebase::OutputBuffer& buffer) {
+                tablebase::append_output_rows(buffer, static_cast<int>(depth), ply);
+            });
+        }
+        writer.write([&table](tablebase::OutputBuffer& buffer) {
+            tablebase::append_output_rows(buffer, table);
+        });
+
+        CHECK(writer.finish() == expected.str().size());
+        CHECK(read_file(path) == expected.str());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Output writer errors") {
+    CHECK_THROWS_AS(tablebase::OutputWriter((std::filesystem::temp_directory_path() / "comp3821_missing" / "output.csv").string()), std::runtime_error);
+
+    // errors inside a chunk are rethrown by finish, and later chunks are skipped
+    auto const path = std::filesystem::temp_directory_path() / "comp3821_output_writer_error.csv";
+    auto writer = tablebase::OutputWriter(path.string());
+    writer.write([](tablebase::OutputBuffer&) {
+        throw std::runtime_error("serialisation failed");
+    });
+    writer.write([](tablebase::OutputBuffer& buffer) {
+        buffer.append_row(1, "8/8/8/8/8/8/8/8", 'w');
+    });
+    CHECK_THROWS_AS(writer.finish(), std::runtime_error);
+    CHECK(not std::filesystem::exists(path));
+    CHECK(not std::filesystem::exists(path.string() + ".tmp"));
+}
+
+TEST_CASE("The previous output is only replaced once the writer finishes") {
+    auto const path = std::filesystem::temp_directory_path() / "comp3821_output_writer_replace.csv";
+    std::ofstream(path) << "previous\n";
+
+    // as when the engine stops early
+    {
+        auto writer = tablebase::OutputWriter(path.string());
+        writer.write([](tablebase::OutputBuffer& buffer) {
+            buffer.append_row(1, "8/8/8/8/8/8/8/8", 'w');
+        });
+    }
+    CHECK(read_file(path) == "previous\n");
+    CHECK(not std::filesystem::exists(path.string() + ".tmp"));
+
+    auto writer = tablebase::OutputWriter(path.string());
+    writer.write([](tablebase::OutputBuffer& buffer) {
+        buffer.append_row(1, "8/8/8/8/8/8/8/8", 'w');
+    });
+    CHECK(read_file(path) == "previous\n");
+    writer.finish();
+    CHECK(read_file(path) == "1 8/8/8/8/8/8/8/8 w\n");
+    CHECK(not std::filesystem::exists(path.string() + ".tmp"));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Solved signatures are handed over as they are solved") {
+    auto solved = std::vector<std::string>{};
+    auto addresses = std::vector<tablebase::DenseTable const*>{};
+    auto const tables = tablebase::solve_signatures_with_bitboards({"kKR", "kK"}, 4, tablebase::SolverStrategy::FRONTIER, [&](tablebase::DenseTable const& table) {
+        solved.push_back(table.signature);
+        addresses.push_back(&table);
+    });
+    CHECK(solved == std::vector<std::string>{"kK", "kKR"});
+    // the tables handed over are the ones returned, so they can be written while solving continues
+    CHECK(addresses == std::vector<tablebase::DenseTable const*>{&tables.at("kK"), &tables.at("kKR")});
+}
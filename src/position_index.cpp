@@ -0,0 +1,256 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <stdexcept>
+#include <chess.hpp>
+#include "position_index.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        auto const NUM_BOARD_SQUARES = 64;
+        auto const BITS_PER_SQUARE = 6;
+
+        // Kings always come first in a signature (black then white, as in our piece combinations),
+        // after which pieces are ordered by their FEN character
+        auto signature_order(char const piece) -> int {
+            if (piece == 'k') return 0;
+            if (piece == 'K') return 1;
+            return 2 + piece;
+        }
+
+        auto compare_by_signature_order(std::pair<char, int> const& lhs, std::pair<char, int> const& rhs) -> bool {
+            if (lhs.first != rhs.first) {
+                return signature_order(lhs.first) < signature_order(rhs.first);
+            }
+            return lhs.second < rhs.second;
+        }
+
+        // Reads the position segment of a FEN string into (piece, square) pairs, using chess-library
+        // square numbering, and returns the position of the player turn character (if there is one)
+        auto parse_FEN_placement(std::string const& FEN_string, std::vector<std::pair<char, int>>& placement) -> std::size_t {
+            auto rank = 7;
+            auto file = 0;
+            auto i = std::size_t{0};
+            for (; i < FEN_string.size() and FEN_string[i] != ' '; ++i) {
+                auto const curr = FEN_string[i];
+                if (curr == '/') {
+                    --rank;
+                    file = 0;
+                } else if (std::isdigit(curr)) {
+                    file += curr - '0';
+                } else {
+                    placement.emplace_back(curr, rank * 8 + file);
+                    ++file;
+                }
+            }
+            return i + 1;
+        }
+    }
+
+
+    auto signature_for_pieces(std::vector<char> pieces) -> std::string {
+        std::sort(pieces.begin(), pieces.end(), [](char const lhs, char const rhs) {
+            return signature_order(lhs) < signature_order(rhs);
+        });
+        return std::string{pieces.begin(), pieces.end()};
+    }
+
+    auto signature_of_FEN(std::string const& FEN_string) -> std::string {
+        auto placement = std::vector<std::pair<char, int>>{};
+        parse_FEN_placement(FEN_string, placement);
+
+        auto pieces = std::vector<char>{};
+        for (auto const& [piece, square] : placement) {
+            pieces.push_back(piece);
+        }
+        return signature_for_pieces(pieces);
+    }
+
+    auto signature_of_board(chess::Board const& board) -> std::string {
+        auto pieces = std::vector<char>{};
+        auto occupied = board.occ();
+        while (occupied.count()) {
+            pieces.push_back(static_cast<std::string>(board.at(chess::Square(occupied.pop())))[0]);
+        }
+        return signature_for_pieces(pieces);
+    }
+
+    auto colour_flipped_signature(std::string const& signature) -> std::string {
+        auto pieces = std::vector<char>{};
+        for (auto const piece : signature) {
+            pieces.push_back(static_cast<char>(std::isupper(piece) ? std::tolower(piece) : std::toupper(piece)));
+        }
+        return signature_for_pieces(pieces);
+    }
+
+    auto colour_flipped_FEN(std::string const& FEN_string) -> std::string {
+        auto const position_end = FEN_string.find(' ');
+        auto const position = FEN_string.substr(0, position_end);
+
+        // reversing the order of the ranks mirrors the board vertically
+        auto ranks = std::vector<std::string>{""};
+        for (auto const curr : position) {
+            if (curr == '/') {
+                ranks.emplace_back();
+            } else {
+                ranks.back().push_back(static_cast<char>(std::isupper(curr) ? std::tolower(curr) : std::toupper(curr)));
+            }
+        }
+
+        auto flipped = std::string{};
+        for (auto rank = ranks.rbegin(); rank != ranks.rend(); ++rank) {
+            if (not flipped.empty()) flipped.push_back('/');
+            flipped.append(*rank);
+        }
+
+        auto const isWhiteTurn = position_end == std::string::npos or FEN_string.substr(position_end + 1, 1) != "b";
+        flipped.append(isWhiteTurn ? " b - - 0 1" : " w - - 0 1");
+        return flipped;
+    }
+
+    PositionIndexer::PositionIndexer(std::string const& signature)
+    : signature_{signature_for_pieces(std::vector<char>{signature.begin(), signature.end()})} {}
+
+    auto PositionIndexer::signature() const -> std::string const& {
+        return signature_;
+    }
+
+    auto PositionIndexer::num_pieces() const -> int {
+        return static_cast<int>(signature_.size());
+    }
+
+    auto PositionIndexer::size() const -> std::uint64_t {
+        return std::uint64_t{2} << (BITS_PER_SQUARE * num_pieces());
+    }
+
+    auto PositionIndexer::index_of_placement(
+        std::vector<std::pair<char, int>> placement,
+        bool const isWhiteTurn
+    ) const -> std::optional<std::uint64_t> {
+        if (placement.size() != signature_.size()) return std::nullopt;
+
+        // sorting by square within each piece type canonicalises identical pieces
+        std::sort(placement.begin(), placement.end(), compare_by_signature_order);
+
+        auto index = std::uint64_t{isWhiteTurn ? 0u : 1u};
+        for (auto i = std::size_t{0}; i < placement.size(); ++i) {
+            if (placement[i].first != signature_[i]) return std::nullopt;
+            index = (index << BITS_PER_SQUARE) | static_cast<std::uint64_t>(placement[i].second);
+        }
+        return index;
+    }
+
+    auto PositionIndexer::index_of_FEN(std::string const& FEN_string) const -> std::optional<std::uint64_t> {
+        auto placement = std::vector<std::pair<char, int>>{};
+        auto const turn_position = parse_FEN_placement(FEN_string, placement);
+        auto const isWhiteTurn = turn_position >= FEN_string.size() or FEN_string[turn_position] != 'b';
+        return index_of_placement(std::move(placement), isWhiteTurn);
+    }
+
+    auto PositionIndexer::index_of_board(chess::Board const& board) const -> std::optional<std::uint64_t> {
+        auto placement = std::vector<std::pair<char, int>>{};
+        auto occupied = board.occ();
+        while (occupied.count()) {
+            auto const sq = chess::Square(occupied.pop());
+            placement.emplace_back(static_cast<std::string>(board.at(sq))[0], sq.index());
+        }
+        return index_of_placement(std::move(placement), board.sideToMove() == chess::Color::WHITE);
+    }
+
+    auto PositionIndexer::squares_at(std::uint64_t index) const -> std::vector<int> {
+        auto squares = std::vector<int>(signature_.size());
+        for (auto i = squares.rbegin(); i != squares.rend(); ++i) {
+            *i = static_cast<int>(index & (NUM_BOARD_SQUARES - 1));
+            index >>= BITS_PER_SQUARE;
+        }
+        return squares;
+    }
+
+    auto PositionIndexer::is_white_turn_at(std::uint64_t const index) const -> bool {
+        return ((index >> (BITS_PER_SQUARE * num_pieces())) & 1) == 0;
+    }
+
+    auto PositionIndexer::king_pair_at(std::uint64_t const index) const -> int {
+        return static_cast<int>((index >> (BITS_PER_SQUARE * (num_pieces() - 2))) & (NUM_BOARD_SQUARES * NUM_BOARD_SQUARES - 1));
+    }
+
+    auto PositionIndexer::FEN_at(std::uint64_t const index) const -> std::optional<std::string> {
+        auto const squares = squares_at(index);
+        auto board_array = std::array<char, NUM_BOARD_SQUARES>{};
+
+        for (auto i = std::size_t{0}; i < squares.size(); ++i) {
+            if (board_array[squares[i]] != '\0') return std::nullopt;
+            if (i > 0 and signature_[i] == signature_[i - 1] and squares[i] < squares[i - 1]) return std::nullopt;
+            board_array[squares[i]] = signature_[i];
+        }
+
+        // FEN strings list ranks from the 8th rank downwards
+        auto FEN_string = std::string{};
+        for (auto rank = 7; rank >= 0; --rank) {
+            auto empty_squares_in_a_row_in_rank = 0;
+            for (auto file = 0; file < 8; ++file) {
+                auto const curr = board_array[rank * 8 + file];
+                if (curr == '\0') {
+                    ++empty_squares_in_a_row_in_rank;
+                    continue;
+                }
+                if (empty_squares_in_a_row_in_rank) {
+                    FEN_string.append(std::to_string(empty_squares_in_a_row_in_rank));
+                    empty_squares_in_a_row_in_rank = 0;
+                }
+                FEN_string.push_back(curr);
+            }
+            if (empty_squares_in_a_row_in_rank) {
+                FEN_string.append(std::to_string(empty_squares_in_a_row_in_rank));
+            }
+            if (rank != 0) {
+                FEN_string.push_back('/');
+            }
+        }
+
+        // Matches the format of helper::board_to_FEN_wrapper
+        FEN_string.append(is_white_turn_at(index) ? " w - - 0 1" : " b - - 0 1");
+        return FEN_string;
+    }
+
+    auto dense_tables_from_tablebase(
+        std::vector<std::unordered_set<std::string>> const& depth_to_mate_forced_wins_for_white,
+        int const depth_to_mate_checked
+    ) -> std::map<std::string, DenseTable> {
+        // entries store the depth to mate plus one in a byte, so deeper wins would wrap around
+        if (depth_to_mate_forced_wins_for_white.size() > static_cast<std::size_t>(MAX_STORED_DEPTH_TO_MATE) + 1) {
+            throw std::runtime_error("Dense tables store depths to mate of at most " + std::to_string(MAX_STORED_DEPTH_TO_MATE)
+                + ", but the tablebase has depths to mate up to " + std::to_string(depth_to_mate_forced_wins_for_white.size() - 1));
+        }
+
+        auto tables = std::map<std::string, DenseTable>{};
+        auto indexers = std::map<std::string, PositionIndexer>{};
+
+        for (auto depth = 0; depth < static_cast<int>(depth_to_mate_forced_wins_for_white.size()); ++depth) {
+            for (auto const& FEN_string : depth_to_mate_forced_wins_for_white[depth]) {
+                auto const signature = signature_of_FEN(FEN_string);
+                auto indexer_iter = indexers.find(signature);
+                if (indexer_iter == indexers.end()) {
+                    indexer_iter = indexers.emplace(signature, PositionIndexer(signature)).first;
+                    tables.emplace(signature, DenseTable{
+                        signature,
+                        depth_to_mate_checked,
+                        TableVector<std::uint8_t>(indexer_iter->second.size(), NOT_A_FORCED_WIN)
+                    });
+                }
+
+                auto const index = indexer_iter->second.index_of_FEN(FEN_string);
+                tables.at(signature).entries[*index] = static_cast<std::uint8_t>(depth + 1);
+            }
+        }
+
+        return tables;
+    }
+
+    auto depth_to_mate_for_entry(std::uint8_t const entry) -> int {
+        return static_cast<int>(entry) - 1;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef COMP3821_PROJ_POSITION_INDEX_HEADER
+#define COMP3821_PROJ_POSITION_INDEX_HEADER
+
+#include <vector>
+#include <string>
+#include <map>
+#include <optional>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <chess.hpp>
+#include "table_memory.h"
+
+namespace tablebase {
+    // Dense tables store depth_to_mate + 1 for each position, leaving 0 for positions that are not
+    // forced wins for white (within the depth to mate that was checked during generation)
+    auto constexpr NOT_A_FORCED_WIN = std::uint8_t{0};
+    auto constexpr MAX_STORED_DEPTH_TO_MATE = 254;
+
+    // Sorts a group of pieces into the order used for signatures across the project, i.e. "kK"
+    // followed by the remaining pieces in ascending order (the same order our generator produces
+    // combinations in, e.g. "kKQn")
+    auto signature_for_pieces(std::vector<char> pieces) -> std::string;
+
+    // Finds the signature for the pieces in the position segment of a FEN string
+    auto signature_of_FEN(std::string const& FEN_string) -> std::string;
+    auto signature_of_board(chess::Board const& board) -> std::string;
+
+    // Swaps the colours of every piece (and mirrors the board vertically). Since our generator only
+    // solves for forced wins for white, a forced win for black in some position is a forced win for
+    // white in its colour flipped position.
+    auto colour_flipped_signature(std::string const& signature) -> std::string;
+    auto colour_flipped_FEN(std::string const& FEN_string) -> std::string;
+
+    // Maps every placement of a signature's pieces (together with the player to move) onto a dense
+    // integer range, so that tables can be stored as flat arrays instead of sets of FEN strings.
+    // The index is laid out as [side to move][square of piece 0]...[square of piece n - 1], using
+    // chess-library square numbering (a1 = 0, h8 = 63), so the last piece of the signature occupies
+    // the lowest 6 bits and each side to move is a contiguous half of the range.
+    // Identical pieces (e.g. the two rooks in "kKRR") are canonicalised by ascending square.
+    class PositionIndexer {
+    public:
+        explicit PositionIndexer(std::string const& signature);
+
+        auto signature() const -> std::string const&;
+        auto num_pieces() const -> int;
+
+        // Number of indices, i.e. 2 * 64^num_pieces (this includes overlapping placements)
+        auto size() const -> std::uint64_t;
+
+        // Returns nullopt if the FEN string does not match our signature
+        auto index_of_FEN(std::string const& FEN_string) const -> std::optional<std::uint64_t>;
+        auto index_of_board(chess::Board const& board) const -> std::optional<std::uint64_t>;
+        // (piece, square) pairs in any order, e.g. {{'k', 60}, {'K', 4}, {'Q', 3}}
+        auto index_of_placement(std::vector<std::pair<char, int>> placement, bool const isWhiteTurn) const -> std::optional<std::uint64_t>;
+
+        // Inverse of the above, returning nullopt for placements with overlapping pieces or for
+        // non-canonical orderings of identical pieces
+        auto FEN_at(std::uint64_t index) const -> std::optional<std::string>;
+
+        // Squares (chess-library numbering) of each piece of the signature, and the side to move
+        auto squares_at(std::uint64_t index) const -> std::vector<int>;
+        auto is_white_turn_at(std::uint64_t index) const -> bool;
+
+        // The king pair (see king_tables.h) of an index, read straight from the layout
+        auto king_pair_at(std::uint64_t const index) const -> int;
+
+    private:
+        std::string signature_;
+    };
+
+    // A tablebase for a single signature in its dense form (see PositionIndexer)
+    struct DenseTable {
+        std::string signature;
+        int max_depth_to_mate;
+        TableVector<std::uint8_t> entries;
+    };
+
+    // Converts the tablebase produced by our generator (sets of FEN strings per depth to mate) into
+    // one dense table per signature present in it. Throws std::runtime_error if a depth to mate is
+    // above MAX_STORED_DEPTH_TO_MATE.
+    auto dense_tables_from_tablebase(
+        std::vector<std::unordered_set<std::string>> const& depth_to_mate_forced_wins_for_white,
+        int const depth_to_mate_checked
+    ) -> std::map<std::string, DenseTable>;
+
+    // Returns the depth to mate for a stored entry, or -1 if the entry is not a forced win
+    auto depth_to_mate_for_entry(std::uint8_t const entry) -> int;
+}
+
+
+#endif // COMP3821_PROJ_POSITION_INDEX_HEADER
@@ -0,0 +1,104 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <optional>
+#include <algorithm>
+#include <chess.hpp>
+#include "helper.h"
+#include "retro_move_counter.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        // Checks that the predecessor is legal and that one of its moves leads back to the position
+        auto check_predecessor(std::string const& FEN_string, std::string const& predecessor_FEN_string) -> std::optional<std::string> {
+            auto predecessor = chess::Board(predecessor_FEN_string);
+            auto const position = chess::Board(FEN_string);
+            if (predecessor.sideToMove() == position.sideToMove()) {
+                return "the predecessor has the same player to move";
+            }
+
+            auto const player_not_to_move = ~predecessor.sideToMove();
+            if (predecessor.isAttacked(predecessor.kingSq(player_not_to_move), predecessor.sideToMove())) {
+                return "the player who is not to move in the predecessor is in check";
+            }
+
+            auto const expected = helper::board_to_FEN_wrapper(position);
+            auto moves = chess::Movelist{};
+            chess::movegen::legalmoves(moves, predecessor);
+            for (auto const move : moves) {
+                predecessor.makeMove(move);
+                auto const reached = helper::board_to_FEN_wrapper(predecessor) == expected;
+                predecessor.unmakeMove(move);
+                if (reached) return std::nullopt;
+            }
+            return "no legal move of the predecessor reaches the position";
+        }
+
+        auto retro_perft_from(
+            std::string const& FEN_string,
+            int const ply,
+            int const depth,
+            int const max_pieces_present,
+            bool const cross_check,
+            RetroPerftResult& result
+        ) -> void {
+            // the predecessor's player to move is the one who did not move in this position
+            auto const is_white_turn = chess::Board(FEN_string).sideToMove() == chess::Color::BLACK;
+
+            auto const start = std::chrono::steady_clock::now();
+            auto const predecessors = helper::generate_predecessor_board_states(FEN_string, is_white_turn, max_pieces_present);
+            result.generation_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            result.nodes_per_depth[static_cast<std::size_t>(ply)] += predecessors.size();
+            for (auto const& predecessor : predecessors) {
+                if (cross_check) {
+                    ++result.predecessors_checked;
+                    if (auto const reason = check_predecessor(FEN_string, predecessor)) {
+                        result.errors.emplace_back(RetroMoveError{FEN_string, predecessor, *reason});
+                        // the predecessors of an illegal position are meaningless
+                        continue;
+                    }
+                }
+                if (ply + 1 < depth) {
+                    retro_perft_from(predecessor, ply + 1, depth, max_pieces_present, cross_check, result);
+                }
+            }
+        }
+    }
+
+
+    auto RetroPerftResult::total_nodes() const -> std::uint64_t {
+        auto total = std::uint64_t{0};
+        for (auto const nodes : nodes_per_depth) {
+            total += nodes;
+        }
+        return total;
+    }
+
+    auto RetroPerftResult::merge(RetroPerftResult const& other) -> void {
+        if (nodes_per_depth.size() < other.nodes_per_depth.size()) {
+            nodes_per_depth.resize(other.nodes_per_depth.size(), 0);
+        }
+        for (auto i = std::size_t{0}; i < other.nodes_per_depth.size(); ++i) {
+            nodes_per_depth[i] += other.nodes_per_depth[i];
+        }
+        predecessors_checked += other.predecessors_checked;
+        errors.insert(errors.end(), other.errors.begin(), other.errors.end());
+        generation_seconds += other.generation_seconds;
+    }
+
+    auto retro_perft(
+        std::string const& FEN_string,
+        int const depth,
+        int const max_pieces_present,
+        bool const cross_check
+    ) -> RetroPerftResult {
+        auto result = RetroPerftResult{};
+        result.nodes_per_depth.resize(static_cast<std::size_t>(std::max(depth, 0)), 0);
+        if (depth > 0) {
+            retro_perft_from(FEN_string, 0, depth, max_pieces_present, cross_check, result);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef COMP3821_PROJ_RETRO_MOVE_COUNTER_HEADER
+#define COMP3821_PROJ_RETRO_MOVE_COUNTER_HEADER
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace tablebase {
+    // A predecessor generated by helper::generate_predecessor_board_states which forward move
+    // generation disagrees with
+    struct RetroMoveError {
+        std::string FEN_string;
+        std::string predecessor_FEN_string;
+        std::string reason;
+    };
+
+    struct RetroPerftResult {
+        // nodes_per_depth[d - 1] is the number of un-move sequences of length d from the position,
+        // counting each distinct predecessor of a position once
+        std::vector<std::uint64_t> nodes_per_depth;
+        // un-moves which were cross-checked by forward move generation (when checking is enabled)
+        std::uint64_t predecessors_checked = 0;
+        std::vector<RetroMoveError> errors;
+        // time spent generating predecessors alone, leaving out the cross-checks
+        double generation_seconds = 0.0;
+
+        auto total_nodes() const -> std::uint64_t;
+        auto merge(RetroPerftResult const& other) -> void;
+    };
+
+    // Counts the predecessors of a position to the given depth, the retrograde equivalent of perft.
+    // Uncaptures are generated while fewer than max_pieces_present pieces are on the board, so
+    // passing the position's own number of pieces counts un-moves without uncaptures. With
+    // cross_check, every predecessor is checked to be legal (the player who is not to move is not
+    // in check) and to reach the position through one of its legal moves. Pawn un-moves are not
+    // generated, so positions with pawns only count the un-moves of their other pieces.
+    auto retro_perft(
+        std::string const& FEN_string,
+        int const depth,
+        int const max_pieces_present,
+        bool const cross_check
+    ) -> RetroPerftResult;
+}
+
+
+#endif // COMP3821_PROJ_RETRO_MOVE_COUNTER_HEADER
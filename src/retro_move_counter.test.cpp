@@ -0,0 +1,176 @@
+#include "./helper.h"
+#include "./position_index.h"
+#include "./retro_move_counter.h"
+#include <catch.hpp>
+#include <chess.hpp>
+#include <set>
+#include <array>
+#include <cctype>
+
+namespace {
+    // Finds every predecessor by trying every legal move of every position of the given signatures
+    // where the player who did not move in the position is to move
+    auto predecessors_by_brute_force(std::string const& FEN_string, std::vector<std::string> const& signatures) -> std::set<std::string> {
+        auto const expected = helper::board_to_FEN_wrapper(chess::Board(FEN_string));
+        auto const is_white_turn = chess::Board(FEN_string).sideToMove() == chess::Color::BLACK;
+
+        auto predecessors = std::set<std::string>{};
+        for (auto const& signature : signatures) {
+            auto const indexer = tablebase::PositionIndexer(signature);
+            for (auto index = std::uint64_t{0}; index < indexer.size(); ++index) {
+                if (indexer.is_white_turn_at(index) != is_white_turn) continue;
+                auto const predecessor_FEN_string = indexer.FEN_at(index);
+                if (not predecessor_FEN_string) continue;
+
+                auto predecessor = chess::Board(*predecessor_FEN_string);
+                if (predecessor.isAttacked(predecessor.kingSq(~predecessor.sideToMove()), predecessor.sideToMove())) continue;
+
+                auto moves = chess::Movelist{};
+                chess::movegen::legalmoves(moves, predecessor);
+                for (auto const move : moves) {
+                    predecessor.makeMove(move);
+                    auto const reached = helper::board_to_FEN_wrapper(predecessor) == expected;
+                    predecessor.unmakeMove(move);
+                    if (reached) {
+                        predecessors.emplace(helper::board_to_FEN_wrapper(predecessor));
+                        break;
+                    }
+                }
+            }
+        }
+        return predecessors;
+    }
+
+    // Squares in FEN order (a8 to h8, down to a1), '\0' for empty squares
+    auto placement_of_FEN(std::string const& FEN_string) -> std::array<char, 64> {
+        auto placement = std::array<char, 64>{};
+        auto square = 0;
+        for (auto const character : FEN_string.substr(0, FEN_string.find(' '))) {
+            if (character == '/') continue;
+            if (std::isdigit(static_cast<unsigned char>(character))) {
+                square += character - '0';
+            } else {
+                placement[static_cast<std::size_t>(square++)] = character;
+            }
+        }
+        return placement;
+    }
+
+    auto FEN_of_placement(std::array<char, 64> const& placement, bool const is_white_turn) -> std::string {
+        auto FEN_string = std::string{};
+        for (auto rank = 0; rank < 8; ++rank) {
+            auto empty = 0;
+            for (auto file = 0; file < 8; ++file) {
+                auto const piece = placement[static_cast<std::size_t>(rank * 8 + file)];
+                if (piece == '\0') {
+                    ++empty;
+                    continue;
+                }
+                if (empty > 0) FEN_string.push_back(static_cast<char>('0' + empty));
+                empty = 0;
+                FEN_string.push_back(piece);
+            }
+            if (empty > 0) FEN_string.push_back(static_cast<char>('0' + empty));
+            if (rank < 7) FEN_string.push_back('/');
+        }
+        return FEN_string + (is_white_turn ? " w - - 0 1" : " b - - 0 1");
+    }
+
+    // Every position which could precede the board by one move of a piece (other than a pawn) of the
+    // player who just moved, to any empty square, and optionally with one of the given pieces
+    // having been captured on the square the piece moved to. Predecessors by forward move
+    // generation are found among these.
+    auto predecessors_by_relocation(std::string const& FEN_string, std::string const& captured_pieces) -> std::set<std::string> {
+        auto const placement = placement_of_FEN(FEN_string);
+        auto const is_white_turn = chess::Board(FEN_string).sideToMove() == chess::Color::BLACK;
+
+        auto candidates = std::vector<std::string>{};
+        for (auto from = std::size_t{0}; from < 64; ++from) {
+            auto const piece = placement[from];
+            if (piece == '\0' or static_cast<bool>(std::isupper(static_cast<unsigned char>(piece))) != is_white_turn) continue;
+            for (auto to = std::size_t{0}; to < 64; ++to) {
+                if (placement[to] != '\0') continue;
+                auto candidate = placement;
+                candidate[to] = piece;
+                candidate[from] = '\0';
+                candidates.emplace_back(FEN_of_placement(candidate, is_white_turn));
+                for (auto const captured : captured_pieces) {
+                    candidate[from] = captured;
+                    candidates.emplace_back(FEN_of_placement(candidate, is_white_turn));
+                }
+            }
+        }
+
+        auto const expected = helper::board_to_FEN_wrapper(chess::Board(FEN_string));
+        auto predecessors = std::set<std::string>{};
+        for (auto const& candidate : candidates) {
+            auto predecessor = chess::Board(candidate);
+            if (predecessor.isAttacked(predecessor.kingSq(~predecessor.sideToMove()), predecessor.sideToMove())) continue;
+
+            auto moves = chess::Movelist{};
+            chess::movegen::legalmoves(moves, predecessor);
+            for (auto const move : moves) {
+                predecessor.makeMove(move);
+                auto const reached = helper::board_to_FEN_wrapper(predecessor) == expected;
+                predecessor.unmakeMove(move);
+                if (reached) {
+                    predecessors.emplace(helper::board_to_FEN_wrapper(predecessor));
+                    break;
+                }
+            }
+        }
+        return predecessors;
+    }
+
+    auto generated_predecessors(std::string const& FEN_string, int const max_pieces_present) -> std::set<std::string> {
+        auto const is_white_turn = chess::Board(FEN_string).sideToMove() == chess::Color::BLACK;
+        auto predecessors = std::set<std::string>{};
+        for (auto const& predecessor : helper::generate_predecessor_board_states(FEN_string, is_white_turn, max_pieces_present)) {
+            predecessors.emplace(helper::board_to_FEN_wrapper(chess::Board(predecessor)));
+        }
+        return predecessors;
+    }
+}
+
+TEST_CASE("Predecessors match every position reaching the board by forward move generation") {
+    SECTION("Un-moves without uncaptures") {
+        for (auto const& FEN_string : {"8/8/8/3k4/8/8/2R5/4K3 b - - 0 1", "3R1k2/8/5K2/8/8/8/8/8 b - - 0 1", "8/8/8/8/2K5/1n6/8/1k6 w - - 0 1"}) {
+            auto const signature = tablebase::signature_of_FEN(FEN_string);
+            CHECK(generated_predecessors(FEN_string, 3) == predecessors_by_brute_force(FEN_string, {signature}));
+        }
+    }
+
+    SECTION("Un-moves with uncaptures") {
+        // the player who just moved may have captured any of the other player's pieces
+        auto const FEN_string = "8/8/8/3k4/8/8/2R5/4K3 b - - 0 1";
+        CHECK(generated_predecessors(FEN_string, 4) == predecessors_by_relocation(FEN_string, "qrbn"));
+        CHECK(generated_predecessors(FEN_string, 3) == predecessors_by_relocation(FEN_string, ""));
+
+        auto const black_moved = "8/8/2Q2n1k/5K2/8/8/8/8 w - - 0 1";
+        CHECK(generated_predecessors(black_moved, 5) == predecessors_by_relocation(black_moved, "QRBN"));
+    }
+}
+
+TEST_CASE("Counting un-moves to a depth") {
+    auto const FEN_string = "8/8/8/3k4/8/8/2R5/4K3 b - - 0 1";
+
+    auto const result = tablebase::retro_perft(FEN_string, 3, 3, true);
+    REQUIRE(result.nodes_per_depth.size() == 3);
+    CHECK(result.errors.empty());
+    CHECK(result.predecessors_checked == result.total_nodes());
+
+    // the first depth is the position's own predecessors, and each later depth sums the
+    // predecessors of the previous depth
+    auto const predecessors = generated_predecessors(FEN_string, 3);
+    CHECK(result.nodes_per_depth[0] == predecessors.size());
+    auto second_depth = std::uint64_t{0};
+    for (auto const& predecessor : predecessors) {
+        second_depth += tablebase::retro_perft(predecessor, 1, 3, false).nodes_per_depth[0];
+    }
+    CHECK(result.nodes_per_depth[1] == second_depth);
+
+    // uncaptures only add predecessors
+    auto const with_uncaptures = tablebase::retro_perft(FEN_string, 2, 4, false);
+    CHECK(with_uncaptures.nodes_per_depth[0] > result.nodes_per_depth[0]);
+    CHECK(with_uncaptures.predecessors_checked == 0);
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <chess.hpp>
+#include "./helper.h"
+#include "./retro_move_counter.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <algorithm>
+
+// Pieces allowed on the board after uncaptures, unless --max-pieces is given
+auto constexpr DEFAULT_MAX_PIECES = 5;
+// Number of errors printed for each position
+auto constexpr DEFAULT_MAX_REPORTED = 10;
+
+namespace {
+    // Pawnless positions (as our generator does not un-move pawns) covering both players to move,
+    // checks, checkmates, and pieces next to the edges and to each other
+    auto const REFERENCE_POSITIONS = std::vector<std::string>{
+        "8/8/8/4k3/8/8/8/4K3 w - - 0 1",
+        "8/8/8/3k4/8/8/2R5/4K3 b - - 0 1",
+        "3R1k2/8/5K2/8/8/8/8/8 b - - 0 1",
+        "6k1/8/5K2/8/1n6/7Q/8/8 w - - 0 1",
+        "8/8/2Q2n1k/5K2/8/8/8/8 b - - 0 1",
+        "k7/8/1K6/8/3B4/8/8/6N1 b - - 0 1",
+        "8/1r6/8/4k3/8/2K5/5R2/8 w - - 0 1",
+    };
+
+    auto print_result_line(std::string const& description, tablebase::RetroPerftResult const& result) -> void {
+        std::cout << "\t" << description << ":";
+        for (auto depth = std::size_t{0}; depth < result.nodes_per_depth.size(); ++depth) {
+            std::cout << " " << result.nodes_per_depth[depth];
+        }
+        std::cout << " (" << result.total_nodes() << " nodes";
+        if (result.generation_seconds > 0.0) {
+            std::cout << ", " << static_cast<std::uint64_t>(static_cast<double>(result.total_nodes()) / result.generation_seconds) << " nodes/sec";
+        }
+        std::cout << ")\n";
+    }
+}
+
+// This program counts the un-moves of our predecessor generation from reference positions, the
+// retrograde equivalent of perft, to benchmark it and to cross-check it against forward move generation
+int main(int argc, char** argv) {
+    auto [positional_arguments, options] = helper::parse_command_line(argc, argv);
+
+    if (positional_arguments.size() < 1) {
+        std::cout << "Usage is:\n"
+            << "./retro_perft   <int>depth    [options]\n\n"
+            << "\tCounts the un-moves from each reference position to the given depth, both without "
+            << "uncaptures and with uncaptures, checking every predecessor against forward move "
+            << "generation and reporting the number of predecessors generated per second.\n\n"
+            << "\tOptions:\n"
+            << "\t--positions=<file> reads the positions from a file with one FEN string per line "
+            << "instead of using the built in reference positions.\n\n"
+            << "\t--max-pieces=<int> number of pieces allowed after uncaptures (defaults to "
+            << DEFAULT_MAX_PIECES << ").\n\n"
+            << "\t--no-cross-check only counts the un-moves, without checking them.\n\n"
+            << "\t--max-reported=<int> number of errors printed per position (defaults to "
+            << DEFAULT_MAX_REPORTED << ").\n\n"
+            ;
+        return 0;
+    }
+
+    auto const depth = std::stoi(positional_arguments[0]);
+    auto const max_pieces = options.contains("max-pieces") ? std::stoi(options["max-pieces"]) : DEFAULT_MAX_PIECES;
+    auto const max_reported = options.contains("max-reported") ? std::stoi(options["max-reported"]) : DEFAULT_MAX_REPORTED;
+    auto const cross_check = not options.contains("no-cross-check");
+    if (depth < 1) {
+        std::cout << "Error: the depth must be at least 1.\n";
+        return 1;
+    }
+
+    auto positions = REFERENCE_POSITIONS;
+    if (options.contains("positions")) {
+        positions.clear();
+        auto file = std::ifstream(options["positions"]);
+        if (not file) {
+            std::cout << "Error: could not open " << options["positions"] << ".\n";
+            return 1;
+        }
+        for (auto line = std::string{}; std::getline(file, line);) {
+            if (not line.empty()) positions.emplace_back(line);
+        }
+    }
+
+    auto total_without_uncaptures = tablebase::RetroPerftResult{};
+    auto total_with_uncaptures = tablebase::RetroPerftResult{};
+    for (auto const& FEN_string : positions) {
+        auto const board = chess::Board(FEN_string);
+        if (board.pieces(chess::PieceType::KING, chess::Color::WHITE).count() != 1 or board.pieces(chess::PieceType::KING, chess::Color::BLACK).count() != 1) {
+            std::cout << "Skipping " << FEN_string << ", which does not have one king per player.\n";
+            continue;
+        }
+        auto const num_pieces = static_cast<int>(board.occ().count());
+
+        std::cout << FEN_string << "\n";
+        // with at most as many pieces as are on the board, no uncaptures are generated
+        auto const without_uncaptures = tablebase::retro_perft(FEN_string, depth, num_pieces, cross_check);
+        print_result_line("without uncaptures", without_uncaptures);
+        auto const with_uncaptures = tablebase::retro_perft(FEN_string, depth, std::max(max_pieces, num_pieces), cross_check);
+        print_result_line("with uncaptures (up to " + std::to_string(std::max(max_pieces, num_pieces)) + " pieces)", with_uncaptures);
+
+        for (auto const* result : {&without_uncaptures, &with_uncaptures}) {
+            for (auto i = 0; i < std::min(max_reported, static_cast<int>(result->errors.size())); ++i) {
+                auto const& error = result->errors[static_cast<std::size_t>(i)];
+                std::cout << "\t" << error.predecessor_FEN_string << " as a predecessor of " << error.FEN_string << ": " << error.reason << "\n";
+            }
+        }
+        total_without_uncaptures.merge(without_uncaptures);
+        total_with_uncaptures.merge(with_uncaptures);
+    }
+
+    std::cout << "Total for " << positions.size() << " positions to depth " << depth << ":\n";
+    print_result_line("without uncaptures", total_without_uncaptures);
+    print_result_line("with uncaptures", total_with_uncaptures);
+
+    auto const num_errors = total_without_uncaptures.errors.size() + total_with_uncaptures.errors.size();
+    if (cross_check) {
+        std::cout << "Checked " << (total_without_uncaptures.predecessors_checked + total_with_uncaptures.predecessors_checked)
+            << " predecessors against forward move generation, " << num_errors << " errors.\n";
+    }
+    return (num_errors == 0) ? 0 : 1;
+}
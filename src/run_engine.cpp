@@ -4,20 +4,111 @@
 #include <stdint.h>
 #include <array>
 #include "./helper.h"
+#include "./position_index.h"
+#include "./compressed_tablebase.h"
+#include "./wdl_bitbase.h"
+#include "./corpus.h"
+#include "./bitbase_solver.h"
+#include "./sharding.h"
+#include "./table_memory.h"
+#include "./output_writer.h"
 #include <string>
 #include <unordered_set>
 #include <fstream>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <utility>
+#include <optional>
+#include <chrono>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // less than two pieces is illegal, more than 5 is too expensive
 auto constexpr MIN_PIECES_ALLOWED = 2;
 auto constexpr MAX_PIECES_ALLOWED = 5;
 
+namespace {
+    // Runs this program again once per shard with the same arguments plus --shard-index and
+    // --run-id, and waits for every worker, stopping the others as soon as one of them fails
+    auto run_shard_workers(
+        int const argc,
+        char** const argv,
+        int const num_shards,
+        std::string const& shard_directory,
+        std::string const& run_id
+    ) -> bool {
+        auto workers = std::vector<pid_t>{};
+        for (auto shard = 0; shard < num_shards; ++shard) {
+            auto arguments = std::vector<std::string>{argv, argv + argc};
+            arguments.emplace_back("--shard-index=" + std::to_string(shard));
+            arguments.emplace_back("--run-id=" + run_id);
+            auto argument_pointers = std::vector<char*>{};
+            for (auto& argument : arguments) {
+                argument_pointers.push_back(argument.data());
+            }
+            argument_pointers.push_back(nullptr);
+
+            auto worker = pid_t{};
+            if (posix_spawnp(&worker, argv[0], nullptr, nullptr, argument_pointers.data(), environ) != 0) {
+                std::cout << "Error: could not start the worker for shard " << shard << ".\n";
+                for (auto const started_worker : workers) {
+                    kill(started_worker, SIGTERM);
+                }
+                return false;
+            }
+            workers.push_back(worker);
+        }
+
+        // only workers which have not been waited for are signalled, as the pids of the others may
+        // already belong to unrelated processes
+        auto running = std::set<pid_t>(workers.begin(), workers.end());
+        auto const stop_running_workers = [&] {
+            tablebase::abort_sharded_solve(shard_directory, run_id);
+            for (auto const worker : running) {
+                kill(worker, SIGTERM);
+            }
+        };
+
+        auto succeeded = true;
+        while (not running.empty()) {
+            auto status = 0;
+            auto const worker = waitpid(-1, &status, 0);
+            if (worker < 0) {
+                if (errno == EINTR) continue;
+                std::cout << "Error: could not wait for the shard workers: " << std::strerror(errno) << ".\n";
+                stop_running_workers();
+                return false;
+            }
+            if (running.erase(worker) == 0) continue;
+            if (WIFEXITED(status) and WEXITSTATUS(status) == 0) continue;
+
+            if (succeeded) {
+                std::cout << "Error: the worker for shard " << (std::find(workers.begin(), workers.end(), worker) - workers.begin())
+                    << " failed, stopping the other workers.\n";
+                stop_running_workers();
+            }
+            succeeded = false;
+        }
+        return succeeded;
+    }
+}
+
 // This program will generate an output csv file to be used as a tablebase for the get_next_move file
 int main(int argc, char** argv) {
-    // Processing command line arguments
-    if (argc < 3) {
+    // Processing command line arguments, where optional flags of the form --name=value may be
+    // given alongside the positional arguments
+    auto [positional_arguments, options] = helper::parse_command_line(argc, argv);
+
+    if (positional_arguments.size() < 2) {
         std::cout << "Usage is:\n"
-            << "./run_engine     <int>max_depth_to_mate   <int>max_num_pieces    <optional string>starting_pieces\n\n\n"
+            << "./run_engine     <int>max_depth_to_mate   <int>max_num_pieces    <optional string>starting_pieces    [options]\n\n\n"
 
             << "\tmax_depth_to_mate is an integer that tells our engine how many unmoves from "
             << "checkmate our engine should explore.\n\n"
@@ -34,14 +125,66 @@ int main(int argc, char** argv) {
             << "various board states for. In the case where this parameter is empty, we solve for "
             << "all combinations of starting pieces that fit the earlier constraints (this "
             << "will likely take significantly longer due to its combinatoric nature).\n\n"
+
+            << "\tOptions:\n"
+            << "\t--compressed-output=<directory> additionally writes one block compressed table "
+            << "(" << tablebase::COMPRESSED_TABLE_EXTENSION << ") per piece signature into the given "
+            << "directory, which can be probed with random access instead of loading output.csv.\n\n"
+
+            << "\t--stored-side=<both|white|black|auto> with --compressed-output, only persists the "
+            << "positions where the given player is to move (auto picks whichever compresses "
+            << "better), resolving probes for the other player with a one move lookahead.\n\n"
+
+            << "\t--wdl-output=<directory> additionally writes one win/draw/loss bitbase ("
+            << tablebase::WDL_BITBASE_EXTENSION << ", 2 bits per position) per piece signature into "
+            << "the given directory, for probing during search.\n\n"
+
+            << "\t--corpus=<file> instead of solving every combination of pieces, only solves the "
+            << "pawnless signatures (with at most max_num_pieces pieces) which occur in the given PGN "
+            << "file or file of FEN strings, along with their colour flips and every signature "
+            << "reachable from them by captures. starting_pieces must be left empty.\n\n"
+
+            << "\t--solver=<fen|bitbase> selects the retrograde solver. fen (the default) un-moves "
+            << "FEN strings one at a time, while bitbase solves each signature over bitboards, "
+            << "handling the 64 squares of one piece at once, which is much faster but needs "
+            << "about 5 * 64^num_pieces bytes of memory per signature.\n\n"
+
+            << "\t--strategy=<frontier|sweep> with --solver=bitbase, frontier (the default) only "
+            << "un-moves the positions won at the previous depth, while sweep scans every position "
+            << "at each depth with AVX2 (when supported), which is faster once most of the table "
+            << "is being won.\n\n"
+
+            << "\t--shards=<int> with --solver=bitbase, splits every signature by king pair into the "
+            << "given number of shards, each solved by a separate worker process, which exchange the "
+            << "wins and predecessors crossing between shards at each depth through files in "
+            << "--shard-directory (defaults to ./shards). The workers are started on this machine "
+            << "unless --external-workers is given, in which case this process only waits for workers "
+            << "started elsewhere (each with the same arguments plus --shard-index=<int>, sharing the "
+            << "directory) and assembles their tables. External workers and this process must then "
+            << "all be given the same --run-id=<id> (letters, digits, - and _), which names the files "
+            << "of this solve so that files left behind by any other solve are never read.\n\n"
+
+            << "\t--shard-timeout=<int> with --shards, the number of seconds a worker (or this process) "
+            << "waits for the files of another shard before failing (defaults to "
+            << tablebase::DEFAULT_SHARD_TIMEOUT.count() << "). A worker which fails also makes every "
+            << "other one stop waiting.\n\n"
+
+            << "\t--huge-pages=<default|off|transparent|explicit> backs large tables with 2MB huge "
+            << "pages, either transparent ones (madvise) or ones from the reserved pool (MAP_HUGETLB, "
+            << "falling back to transparent ones when the pool is empty), which cuts TLB misses on "
+            << "tables of many gigabytes. off prevents huge pages even when the system enables them "
+            << "for every allocation.\n\n"
+
+            << "\t--numa=<local|interleave> places the pages of large tables on the NUMA node first "
+            << "touching them (local, the default), or spreads them over every node.\n\n"
             ;
 
         return 0;
     }
 
-    const int depth_to_mate_checked = std::stoi(argv[1]);
-    const int max_pieces_present = std::stoi(argv[2]);
-    const auto starting_pieces_string = (argc == 4) ? std::string{argv[3]} : std::string{};
+    const int depth_to_mate_checked = std::stoi(positional_arguments[0]);
+    const int max_pieces_present = std::stoi(positional_arguments[1]);
+    const auto starting_pieces_string = (positional_arguments.size() == 3) ? positional_arguments[2] : std::string{};
     const auto starting_pieces = std::vector<char>{starting_pieces_string.begin(), starting_pieces_string.end()};
 
     if (
@@ -55,11 +198,124 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    auto const solver_option = options.contains("solver") ? options["solver"] : std::string{"fen"};
+    if (solver_option != "fen" and solver_option != "bitbase") {
+        std::cout << "Error: --solver must be one of fen or bitbase.\n";
+        return 1;
+    }
+    auto const use_bitboards = solver_option == "bitbase";
+
+    auto const strategy_option = options.contains("strategy") ? options["strategy"] : std::string{"frontier"};
+    if (strategy_option != "frontier" and strategy_option != "sweep") {
+        std::cout << "Error: --strategy must be one of frontier or sweep.\n";
+        return 1;
+    }
+    if (options.contains("strategy") and not use_bitboards) {
+        std::cout << "Error: --strategy is only supported by --solver=bitbase.\n";
+        return 1;
+    }
+    auto const strategy = (strategy_option == "sweep") ? tablebase::SolverStrategy::SWEEP : tablebase::SolverStrategy::FRONTIER;
+
+    auto const num_shards = options.contains("shards") ? std::stoi(options["shards"]) : 0;
+    auto const shard_directory = options.contains("shard-directory") ? options["shard-directory"] : std::string{"shards"};
+    if (options.contains("shards") and (not use_bitboards or strategy != tablebase::SolverStrategy::FRONTIER)) {
+        std::cout << "Error: --shards is only supported by --solver=bitbase with the frontier strategy.\n";
+        return 1;
+    }
+    if (options.contains("shards") and (num_shards < 1 or num_shards > tablebase::NUM_KING_PAIRS)) {
+        std::cout << "Error: --shards must be between 1 and " << tablebase::NUM_KING_PAIRS << ".\n";
+        return 1;
+    }
+    if ((options.contains("shard-index") or options.contains("external-workers") or options.contains("shard-timeout")) and not options.contains("shards")) {
+        std::cout << "Error: --shard-index, --external-workers and --shard-timeout require --shards.\n";
+        return 1;
+    }
+    if ((options.contains("shard-index") or options.contains("external-workers")) and not options.contains("run-id")) {
+        std::cout << "Error: --shard-index and --external-workers require --run-id.\n";
+        return 1;
+    }
+    if (options.contains("run-id") and not tablebase::is_valid_shard_run_id(options["run-id"])) {
+        std::cout << "Error: --run-id must only contain letters, digits, - and _.\n";
+        return 1;
+    }
+    // workers started by this process are given an identifier unique to this solve
+    auto const shard_run_id = options.contains("run-id") ? options["run-id"] : tablebase::new_shard_run_id();
+    auto const shard_timeout = options.contains("shard-timeout") ? std::chrono::seconds(std::stoi(options["shard-timeout"])) : tablebase::DEFAULT_SHARD_TIMEOUT;
+    if (shard_timeout.count() < 1) {
+        std::cout << "Error: --shard-timeout must be at least 1 second.\n";
+        return 1;
+    }
+
+    if (depth_to_mate_checked > tablebase::MAX_STORED_DEPTH_TO_MATE and (options.contains("compressed-output") or options.contains("wdl-output") or use_bitboards)) {
+        std::cout << "Error: compressed tables, bitbases and the bitbase solver support depths to "
+            << "mate of at most " << tablebase::MAX_STORED_DEPTH_TO_MATE << ".\n";
+        return 1;
+    }
+
+    auto const stored_side_option = options.contains("stored-side") ? options["stored-side"] : std::string{"both"};
+    if (stored_side_option != "both" and stored_side_option != "white" and stored_side_option != "black" and stored_side_option != "auto") {
+        std::cout << "Error: --stored-side must be one of both, white, black or auto.\n";
+        return 1;
+    }
+
+
+    auto const huge_pages = tablebase::huge_pages_from_string(options.contains("huge-pages") ? options["huge-pages"] : std::string{"default"});
+    if (not huge_pages) {
+        std::cout << "Error: --huge-pages must be one of default, off, transparent or explicit.\n";
+        return 1;
+    }
+    auto const numa_placement = tablebase::numa_placement_from_string(options.contains("numa") ? options["numa"] : std::string{"local"});
+    if (not numa_placement) {
+        std::cout << "Error: --numa must be one of local or interleave.\n";
+        return 1;
+    }
+    tablebase::set_default_table_memory(tablebase::TableMemory{*huge_pages, *numa_placement});
+
+
+    if (options.contains("corpus") and not starting_pieces.empty()) {
+        std::cout << "Error: starting_pieces cannot be provided alongside --corpus.\n";
+        return 1;
+    }
+
 
     // ALGORITHM IMPLEMENTATION FOR ENDGAME TABLEBASE GENERATION BEGINS HERE
     // Generate combinations of pieces from which to generate checkmates for retrograde analysis
     auto piece_combinations = std::vector<std::vector<char>>{};
-    if (starting_pieces.empty()) {
+    // When solving for a corpus, uncaptures are restricted to these signatures, as no position of
+    // any other signature can be reached (through moves and captures) from those in the corpus
+    auto allowed_signatures = std::set<std::string>{};
+    if (options.contains("corpus")) {
+        auto const histogram = tablebase::signature_histogram_of_corpus(options["corpus"], max_pieces_present);
+        if (histogram.empty()) {
+            std::cout << "Error: no pawnless positions with at most " << max_pieces_present
+                << " pieces were found in " << options["corpus"] << ".\n";
+            return 1;
+        }
+
+        auto corpus_signatures = std::vector<std::string>{};
+        for (auto const& [signature, count] : histogram) {
+            corpus_signatures.emplace_back(signature);
+        }
+        allowed_signatures = tablebase::signatures_required_for(corpus_signatures);
+
+        // the most frequent signatures are solved first, followed by the dependencies which were
+        // not in the corpus themselves
+        auto frequency = [&histogram](std::string const& signature) -> std::uint64_t {
+            auto const count = histogram.find(signature);
+            return (count == histogram.end()) ? 0 : count->second;
+        };
+        auto ordered_signatures = std::vector<std::string>{allowed_signatures.begin(), allowed_signatures.end()};
+        std::stable_sort(ordered_signatures.begin(), ordered_signatures.end(), [&frequency](std::string const& lhs, std::string const& rhs) {
+            return frequency(lhs) > frequency(rhs);
+        });
+
+        std::cout << "Found " << histogram.size() << " signatures in the corpus, requiring "
+            << allowed_signatures.size() << " signatures to be solved:\n";
+        for (auto const& signature : ordered_signatures) {
+            std::cout << "\t" << signature << ": " << frequency(signature) << " positions\n";
+            piece_combinations.emplace_back(signature.begin(), signature.end());
+        }
+    } else if (starting_pieces.empty()) {
         // This version of the function generates all piece combinations with a number of pieces
         // less than or equal to the max_pieces_present supplied
         piece_combinations = std::move(helper::generate_piece_combinations(max_pieces_present));
@@ -72,97 +328,258 @@ int main(int argc, char** argv) {
     // This is according to n + k - 1 choose k, where n = 10, k = max_pieces_present, unless pieces are provided
     std::cout << "There are " << piece_combinations.size() << " combinations of pieces.\n";
 
-    // For now we use an unordered set of strings, as the chess::Board type does not overload the
-    // == operator in a manner that allows for unordered_set to be used for it
-    auto checkmate_states = std::unordered_set<std::string>();
-    for (auto i : piece_combinations) {
-        auto combination = std::string{};
-        for (auto j : i) {
-            combination.push_back(j);
-        }
-
-        std::cout << "Now generating checkmates for new piece combination: " << combination << "\n";
-        auto some_checkmates = helper::generate_checkmates_for_piece_set_for_player(i);
-        for (auto j : some_checkmates) {
-            checkmate_states.insert(j);
-        }
-    }
-
-
-    // A set of all states with forceable wins for white (regardless of depth to mate, and 
-    // containing board states from the turns of both white and black players)
-    auto states_with_forceable_wins_for_white = std::unordered_set<std::string>();
-    states_with_forceable_wins_for_white.insert(checkmate_states.begin(), checkmate_states.end());
-
-    // We use a vector to allow us to store the following information:
-    // let n = index of element in vector
-    // if n is even, then the element represents it being the black players turn and there being n
-    //      moves left before forced checkmate (i.e. the black player can take any move and will
-    //      still lose)
-    // if n is odd, then the element represents it being the white players turn and there being n
-    //      moves left before forced checkmate (i.e. the white player has some move to take that
-    //      will allow them to force a win from that point onwards)
-    auto depth_to_mate_forced_wins_for_white = std::vector<std::unordered_set<std::string>>{};
-    depth_to_mate_forced_wins_for_white.emplace_back(checkmate_states);
-
-
-    while (depth_to_mate_forced_wins_for_white.size() <= depth_to_mate_checked) {
-        std::cout << "Checking for new move depth: "
-            << depth_to_mate_forced_wins_for_white.size()
-            << ", last iteration had "
-            << depth_to_mate_forced_wins_for_white.back().size()
-            << " boards.\n";
-        auto curr_depth_forced_wins = std::unordered_set<std::string>();
-        for (auto i : depth_to_mate_forced_wins_for_white.back()) {
-            if (depth_to_mate_forced_wins_for_white.size() % 2 == 1) {
-                // It's white's move this turn
-                // These are states where white can select a move that will result in them winning
-                auto possible_predecessor_boards = helper::generate_predecessor_board_states(i, true, max_pieces_present);
-
-                for (auto j : possible_predecessor_boards) {
-                    // Avoid recalculation for states we already know to be winning
-                    if (not states_with_forceable_wins_for_white.contains(j)) {
-                        curr_depth_forced_wins.emplace(j);
-                    }
+    // Every solved signature gets a compressed table and a bitbase (even those without any forced
+    // wins) so that positions without forced wins can be told apart from signatures we know nothing
+    // about
+    auto solved_signatures = std::set<std::string>{};
+    for (auto const& pieces : piece_combinations) {
+        solved_signatures.insert(tablebase::signature_for_pieces(pieces));
+    }
+
+    // Dense tables are only needed for the alternative output formats, unless the bitbase solver
+    // produces them directly
+    auto dense_tables = std::map<std::string, tablebase::DenseTable>{};
+
+    if (use_bitboards) {
+        if (options.contains("shard-index")) {
+            // this is a worker, which leaves writing the output to the coordinator
+            auto const shard = std::stoi(options["shard-index"]);
+            std::cout << "Solving shard " << shard << " of " << num_shards << ".\n";
+            try {
+                tablebase::solve_shard_of_signatures(solved_signatures, depth_to_mate_checked, shard_directory, shard_run_id, shard, num_shards, shard_timeout);
+            } catch (std::runtime_error const& error) {
+                std::cout << "Error: shard " << shard << " failed: " << error.what() << "\n";
+                return 1;
+            }
+            return 0;
+        }
+
+        // output.csv is written in the same format as below, grouped by signature instead of depth,
+        // with each signature written in the background as soon as it is solved (the solver's map
+        // of tables is moved into dense_tables, which leaves the tables being written in place)
+        auto output_writer = std::optional<tablebase::OutputWriter>{};
+        try {
+            output_writer.emplace("output.csv");
+        } catch (std::runtime_error const& error) {
+            std::cout << "Error: " << error.what() << "\n";
+            return 1;
+        }
+        auto const write_output_rows = [&output_writer](tablebase::DenseTable const& table) {
+            output_writer->write([&table](tablebase::OutputBuffer& buffer) {
+                tablebase::append_output_rows(buffer, table);
+            });
+        };
+
+        if (options.contains("shards")) {
+            std::filesystem::create_directories(shard_directory);
+            if (not options.contains("external-workers")) {
+                // other solves may be using the same directory, so only this run's files go
+                tablebase::clear_shard_directory(shard_directory, shard_run_id);
+                if (not run_shard_workers(argc, argv, num_shards, shard_directory, shard_run_id)) {
+                    return 1;
                 }
+            }
+            try {
+                dense_tables = tablebase::read_sharded_tables(solved_signatures, depth_to_mate_checked, shard_directory, shard_run_id, num_shards, shard_timeout);
+            } catch (std::runtime_error const& error) {
+                std::cout << "Error: " << error.what() << "\n";
+                return 1;
+            }
+            tablebase::clear_shard_directory(shard_directory, shard_run_id);
+            for (auto const& [signature, table] : dense_tables) {
+                write_output_rows(table);
+            }
+        } else {
+            if (strategy == tablebase::SolverStrategy::SWEEP) {
+                std::cout << "Sweeping with " << tablebase::bitbase_sweep_instruction_set() << " kernels.\n";
+            }
+            dense_tables = tablebase::solve_signatures_with_bitboards(solved_signatures, depth_to_mate_checked, strategy, write_output_rows);
+        }
+        // output.csv is only replaced here, so a run which fails before then leaves the last one as it was
+        try {
+            output_writer->finish();
+        } catch (std::runtime_error const& error) {
+            std::cout << "Error: " << error.what() << "\n";
+            return 1;
+        }
+    } else {
+        // For now we use an unordered set of strings, as the chess::Board type does not overload the
+        // == operator in a manner that allows for unordered_set to be used for it
+        auto checkmate_states = std::unordered_set<std::string>();
+        for (auto i : piece_combinations) {
+            auto combination = std::string{};
+            for (auto j : i) {
+                combination.push_back(j);
+            }
+
+            std::cout << "Now generating checkmates for new piece combination: " << combination << "\n";
+            auto some_checkmates = helper::generate_checkmates_for_piece_set_for_player(i);
+            for (auto j : some_checkmates) {
+                checkmate_states.insert(j);
+            }
+        }
+
+
+        // A set of all states with forceable wins for white (regardless of depth to mate, and 
+        // containing board states from the turns of both white and black players)
+        auto states_with_forceable_wins_for_white = std::unordered_set<std::string>();
+        states_with_forceable_wins_for_white.insert(checkmate_states.begin(), checkmate_states.end());
+
+        // We use a vector to allow us to store the following information:
+        // let n = index of element in vector
+        // if n is even, then the element represents it being the black players turn and there being n
+        //      moves left before forced checkmate (i.e. the black player can take any move and will
+        //      still lose)
+        // if n is odd, then the element represents it being the white players turn and there being n
+        //      moves left before forced checkmate (i.e. the white player has some move to take that
+        //      will allow them to force a win from that point onwards)
+        auto depth_to_mate_forced_wins_for_white = std::vector<std::unordered_set<std::string>>{};
+        depth_to_mate_forced_wins_for_white.reserve(static_cast<std::size_t>(depth_to_mate_checked) + 1);
+        depth_to_mate_forced_wins_for_white.emplace_back(std::move(checkmate_states));
+
+        // Each ply is written to output.csv in the background once the next ply has been generated
+        // from it. Unless the dense tables below need every ply, the ply is moved into the writer,
+        // which frees it as soon as it has been written (the reserve above keeps the plies in place
+        // for those written by reference).
+        auto output_writer = std::optional<tablebase::OutputWriter>{};
+        try {
+            output_writer.emplace("output.csv");
+        } catch (std::runtime_error const& error) {
+            std::cout << "Error: " << error.what() << "\n";
+            return 1;
+        }
+        auto const keep_plies = options.contains("compressed-output") or options.contains("wdl-output");
+        auto const write_ply = [&](std::size_t const depth) {
+            if (keep_plies) {
+                output_writer->write([depth, &ply = depth_to_mate_forced_wins_for_white[depth]](tablebase::OutputBuffer& buffer) {
+                    tablebase::append_output_rows(buffer, static_cast<int>(depth), ply);
+                });
             } else {
-                // It's black's move this turn
-                // These are states where whatever move black takes, they will lose in the end
-                auto possible_predecessor_boards = helper::generate_predecessor_board_states(i, false, max_pieces_present);
-                for (auto j: possible_predecessor_boards) {
-                    if (helper::is_forced_win(j, states_with_forceable_wins_for_white)) {
+                output_writer->write([depth, ply = std::exchange(depth_to_mate_forced_wins_for_white[depth], {})](tablebase::OutputBuffer& buffer) {
+                    tablebase::append_output_rows(buffer, static_cast<int>(depth), ply);
+                });
+            }
+        };
+
+
+        while (depth_to_mate_forced_wins_for_white.size() <= depth_to_mate_checked) {
+            std::cout << "Checking for new move depth: "
+                << depth_to_mate_forced_wins_for_white.size()
+                << ", last iteration had "
+                << depth_to_mate_forced_wins_for_white.back().size()
+                << " boards.\n";
+            auto curr_depth_forced_wins = std::unordered_set<std::string>();
+            for (auto i : depth_to_mate_forced_wins_for_white.back()) {
+                if (depth_to_mate_forced_wins_for_white.size() % 2 == 1) {
+                    // It's white's move this turn
+                    // These are states where white can select a move that will result in them winning
+                    auto possible_predecessor_boards = helper::generate_predecessor_board_states(i, true, max_pieces_present, allowed_signatures.empty() ? nullptr : &allowed_signatures);
+
+                    for (auto j : possible_predecessor_boards) {
                         // Avoid recalculation for states we already know to be winning
                         if (not states_with_forceable_wins_for_white.contains(j)) {
                             curr_depth_forced_wins.emplace(j);
                         }
                     }
+                } else {
+                    // It's black's move this turn
+                    // These are states where whatever move black takes, they will lose in the end
+                    auto possible_predecessor_boards = helper::generate_predecessor_board_states(i, false, max_pieces_present, allowed_signatures.empty() ? nullptr : &allowed_signatures);
+                    for (auto j: possible_predecessor_boards) {
+                        if (helper::is_forced_win(j, states_with_forceable_wins_for_white)) {
+                            // Avoid recalculation for states we already know to be winning
+                            if (not states_with_forceable_wins_for_white.contains(j)) {
+                                curr_depth_forced_wins.emplace(j);
+                            }
+                        }
+                    }
                 }
             }
+
+            states_with_forceable_wins_for_white.insert(curr_depth_forced_wins.begin(), curr_depth_forced_wins.end());
+            depth_to_mate_forced_wins_for_white.emplace_back(std::move(curr_depth_forced_wins));
+            write_ply(depth_to_mate_forced_wins_for_white.size() - 2);
+        }
+        write_ply(depth_to_mate_forced_wins_for_white.size() - 1);
+        // output.csv is only replaced here, so a run which fails before then leaves the last one as it was
+        try {
+            output_writer->finish();
+        } catch (std::runtime_error const& error) {
+            std::cout << "Error: " << error.what() << "\n";
+            return 1;
         }
 
-        depth_to_mate_forced_wins_for_white.emplace_back(curr_depth_forced_wins);
-        states_with_forceable_wins_for_white.insert(curr_depth_forced_wins.begin(), curr_depth_forced_wins.end());
+
+        // Dense tables are only needed for the alternative output formats
+        if (options.contains("compressed-output") or options.contains("wdl-output")) {
+            dense_tables = tablebase::dense_tables_from_tablebase(depth_to_mate_forced_wins_for_white, depth_to_mate_checked);
+        }
     }
 
+    if (options.contains("compressed-output")) {
+        auto const directory = std::filesystem::path(options["compressed-output"]);
+        std::filesystem::create_directories(directory);
 
-    // POST PROCESSING OF OUR RESULTANT ENDGAME TABLEBASE OCCURS HERE, MAINLY FOR SAVING OUTPUT
-    auto output_file = std::ofstream("output.csv");
+        for (auto const& signature : solved_signatures) {
+            // signatures without any forced wins are written as tables of NOT_A_FORCED_WIN, which
+            // compress down to almost nothing
+            auto const dense_table = dense_tables.find(signature);
+            auto empty_table = tablebase::DenseTable{};
+            if (dense_table == dense_tables.end()) {
+                empty_table = tablebase::DenseTable{
+                    signature,
+                    depth_to_mate_checked,
+                    tablebase::TableVector<std::uint8_t>(tablebase::PositionIndexer(signature).size(), tablebase::NOT_A_FORCED_WIN)
+                };
+            }
+            auto const& table = (dense_table == dense_tables.end()) ? empty_table : dense_table->second;
 
-    // C++ streaming input from a file splits it by whitespace, so here we format our output
-    // to take advantage of this in the form "depth_to_mate FEN_position_segment player_turn"
-    // for each row of a CSV file
-    for (auto i = 0; i < depth_to_mate_forced_wins_for_white.size(); ++i) {
-        for (auto j : depth_to_mate_forced_wins_for_white[i]) {
-            auto FEN_position_segment = std::string{};
+            auto stored_sides = tablebase::StoredSides::BOTH;
+            if (stored_side_option == "white") {
+                stored_sides = tablebase::StoredSides::WHITE_TO_MOVE;
+            } else if (stored_side_option == "black") {
+                stored_sides = tablebase::StoredSides::BLACK_TO_MOVE;
+            } else if (stored_side_option == "auto") {
+                stored_sides = tablebase::choose_side_to_store(table);
+            }
 
-            auto j_iter = j.begin();
-            for (; *j_iter != ' '; ++j_iter) {
-                FEN_position_segment.push_back(*j_iter);
+            auto const path = directory / (signature + tablebase::COMPRESSED_TABLE_EXTENSION);
+            auto const compressed_size = tablebase::write_compressed_table(table, path.string(), tablebase::DEFAULT_BLOCK_SIZE, stored_sides);
+            std::cout << "Wrote " << path.string() << " (" << table.entries.size() << " positions, "
+                << compressed_size << " bytes compressed";
+            if (stored_sides != tablebase::StoredSides::BOTH) {
+                std::cout << ", only " << ((stored_sides == tablebase::StoredSides::WHITE_TO_MOVE) ? "white" : "black")
+                    << " to move stored";
             }
+            std::cout << ").\n";
+        }
+    }
 
-            auto player_turn = *(++j_iter);
+    if (options.contains("wdl-output")) {
+        auto const directory = std::filesystem::path(options["wdl-output"]);
+        std::filesystem::create_directories(directory);
 
-            output_file << i << " " << FEN_position_segment << " " << player_turn << "\n";
+        for (auto const& signature : solved_signatures) {
+            auto const colour_flipped_signature = tablebase::colour_flipped_signature(signature);
+            auto const table = dense_tables.find(signature);
+            auto const colour_flipped_table = dense_tables.find(colour_flipped_signature);
+            auto const losses_resolved = solved_signatures.contains(colour_flipped_signature);
+
+            auto const bitbase = tablebase::generate_wdl_bitbase(
+                signature,
+                depth_to_mate_checked,
+                (table == dense_tables.end()) ? nullptr : &table->second,
+                (colour_flipped_table == dense_tables.end()) ? nullptr : &colour_flipped_table->second,
+                losses_resolved
+            );
+
+            auto const path = directory / (signature + tablebase::WDL_BITBASE_EXTENSION);
+            auto const bitbase_size = tablebase::write_wdl_bitbase(bitbase, path.string());
+            std::cout << "Wrote " << path.string() << " (" << bitbase_size << " bytes).\n";
+            if (not losses_resolved) {
+                std::cout << "\tNote: " << colour_flipped_signature << " was not generated, so forced "
+                    << "wins for black in " << signature << " are stored as draws.\n";
+            }
         }
     }
 
@@ -0,0 +1,330 @@
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <cctype>
+#include <unistd.h>
+#include "sharding.h"
+#include "bitbase_solver.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        auto constexpr BITS_PER_SQUARE = 6;
+        auto constexpr TEMPORARY_EXTENSION = ".tmp";
+        // How long to sleep between checks for the files of other shards
+        auto constexpr POLL_INTERVAL = std::chrono::milliseconds(1);
+
+        template <typename T>
+        auto write_value(std::ofstream& file, T const& value) -> void {
+            file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        auto read_value(std::ifstream& file) -> T {
+            auto value = T{};
+            file.read(reinterpret_cast<char*>(&value), sizeof(T));
+            return value;
+        }
+
+        auto write_config_bits(std::ofstream& file, std::vector<ConfigBits> const& updates) -> void {
+            write_value(file, static_cast<std::uint64_t>(updates.size()));
+            file.write(reinterpret_cast<char const*>(updates.data()), static_cast<std::streamsize>(updates.size() * sizeof(ConfigBits)));
+        }
+
+        auto read_config_bits(std::ifstream& file, std::vector<ConfigBits>& updates) -> void {
+            auto const size = read_value<std::uint64_t>(file);
+            auto const previous_size = updates.size();
+            updates.resize(previous_size + size);
+            file.read(reinterpret_cast<char*>(updates.data() + previous_size), static_cast<std::streamsize>(size * sizeof(ConfigBits)));
+        }
+
+        // Writes a file under a temporary name, then renames it so that it appears complete
+        template <typename Writer>
+        auto write_atomically(std::filesystem::path const& path, Writer const& writer) -> void {
+            auto temporary_path = path;
+            temporary_path += TEMPORARY_EXTENSION;
+            {
+                auto file = std::ofstream(temporary_path, std::ios::binary | std::ios::trunc);
+                if (not file) {
+                    throw std::runtime_error("Could not write " + temporary_path.string());
+                }
+                writer(file);
+            }
+            std::filesystem::rename(temporary_path, path);
+        }
+
+        auto abort_path(std::string const& directory, std::string const& run_id) -> std::filesystem::path {
+            return std::filesystem::path(directory) / (run_id + SHARD_ABORT_EXTENSION);
+        }
+
+        auto wait_for_file(
+            std::filesystem::path const& path,
+            std::string const& directory,
+            std::string const& run_id,
+            std::chrono::seconds const timeout
+        ) -> void {
+            auto const deadline = std::chrono::steady_clock::now() + timeout;
+            while (not std::filesystem::exists(path)) {
+                if (std::filesystem::exists(abort_path(directory, run_id))) {
+                    throw std::runtime_error("Stopped waiting for " + path.string() + " as the sharded solve was aborted");
+                }
+                if (std::chrono::steady_clock::now() > deadline) {
+                    throw std::runtime_error("Timed out after " + std::to_string(timeout.count()) + " seconds waiting for " + path.string());
+                }
+                std::this_thread::sleep_for(POLL_INTERVAL);
+            }
+        }
+
+        auto delta_path(
+            std::string const& directory,
+            std::string const& run_id,
+            std::string const& signature,
+            int const depth,
+            int const from,
+            int const to
+        ) -> std::filesystem::path {
+            return std::filesystem::path(directory) / (run_id + "." + signature + "." + std::to_string(depth) + "." + std::to_string(from) + "." + std::to_string(to) + SHARD_DELTA_EXTENSION);
+        }
+
+        auto table_part_path(std::string const& directory, std::string const& run_id, std::string const& signature, int const shard) -> std::filesystem::path {
+            return std::filesystem::path(directory) / (run_id + "." + signature + "." + std::to_string(shard) + SHARD_TABLE_EXTENSION);
+        }
+
+        auto read_table_parts(
+            std::string const& directory,
+            std::string const& run_id,
+            std::string const& signature,
+            int const max_depth_to_mate,
+            int const num_shards,
+            std::chrono::seconds const timeout
+        ) -> DenseTable {
+            auto table = DenseTable{signature, max_depth_to_mate, TableVector<std::uint8_t>(PositionIndexer(signature).size(), NOT_A_FORCED_WIN)};
+
+            for (auto shard = 0; shard < num_shards; ++shard) {
+                auto const path = table_part_path(directory, run_id, signature, shard);
+                wait_for_file(path, directory, run_id, timeout);
+
+                auto file = std::ifstream(path, std::ios::binary);
+                auto const stored_num_shards = read_value<std::int32_t>(file);
+                auto const stored_max_depth_to_mate = read_value<std::int32_t>(file);
+                if (not file or stored_num_shards != num_shards or stored_max_depth_to_mate != max_depth_to_mate) {
+                    throw std::runtime_error(path.string() + " is not part of a solve with " + std::to_string(num_shards)
+                        + " shards to depth " + std::to_string(max_depth_to_mate));
+                }
+
+                for (auto const& [begin, end] : index_ranges_of_king_pairs(signature, king_pair_range_of_shard(shard, num_shards))) {
+                    file.read(reinterpret_cast<char*>(table.entries.data() + begin), static_cast<std::streamsize>(end - begin));
+                }
+                if (not file) {
+                    throw std::runtime_error(path.string() + " is truncated");
+                }
+            }
+            return table;
+        }
+
+        // Solves the signatures from the fewest pieces upwards, writing this shard's part of each
+        auto solve_shard(std::set<std::string> const& signatures, int const max_depth_to_mate, ShardExchange const& exchange) -> void {
+            auto ordered_signatures = std::vector<std::string>{};
+            for (auto const& signature : signatures) {
+                ordered_signatures.emplace_back(signature_for_pieces(std::vector<char>{signature.begin(), signature.end()}));
+            }
+            std::stable_sort(ordered_signatures.begin(), ordered_signatures.end(), [](std::string const& lhs, std::string const& rhs) {
+                return lhs.size() < rhs.size();
+            });
+
+            // only the tables of signatures with fewer pieces than the largest one are needed to
+            // resolve captures
+            auto const largest_size = ordered_signatures.empty() ? std::size_t{0} : ordered_signatures.back().size();
+            auto tables = std::map<std::string, DenseTable>{};
+
+            for (auto const& signature : ordered_signatures) {
+                if (signature.size() < 3) {
+                    // king pairs do not line up with configs of kK, which is solved whole by every shard
+                    // (it has no forced wins, so this is instant) and cut down to this shard's part
+                    auto table = solve_signature_with_bitboards(signature, max_depth_to_mate, tables);
+                    auto table_part = DenseTable{signature, max_depth_to_mate, {}};
+                    for (auto const& [begin, end] : index_ranges_of_king_pairs(signature, exchange.king_pairs())) {
+                        table_part.entries.insert(table_part.entries.end(), table.entries.begin() + begin, table.entries.begin() + end);
+                    }
+                    exchange.write_table_part(table_part);
+                    tables.emplace(signature, std::move(table));
+                    continue;
+                }
+
+                exchange.write_table_part(solve_signature_shard_with_bitboards(signature, max_depth_to_mate, tables, exchange));
+                if (signature.size() < largest_size) {
+                    tables.emplace(signature, exchange.read_table(signature, max_depth_to_mate));
+                }
+            }
+        }
+    }
+
+
+    auto is_valid_shard_run_id(std::string const& run_id) -> bool {
+        return not run_id.empty() and std::all_of(run_id.begin(), run_id.end(), [](char const character) {
+            return std::isalnum(static_cast<unsigned char>(character)) or character == '-' or character == '_';
+        });
+    }
+
+    auto new_shard_run_id() -> std::string {
+        auto const now = std::chrono::system_clock::now().time_since_epoch();
+        return std::to_string(getpid()) + "-" + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+    }
+
+    auto king_pair_range_of_shard(int const shard, int const num_shards) -> KingPairRange {
+        return KingPairRange{NUM_KING_PAIRS * shard / num_shards, NUM_KING_PAIRS * (shard + 1) / num_shards};
+    }
+
+    auto index_ranges_of_king_pairs(std::string const& signature, KingPairRange const king_pairs) -> std::array<std::pair<std::uint64_t, std::uint64_t>, 2> {
+        // each king pair is followed by the squares of the remaining pieces
+        auto const indices_per_king_pair = std::uint64_t{1} << (BITS_PER_SQUARE * (static_cast<int>(signature.size()) - 2));
+        auto const indices_per_side = indices_per_king_pair * NUM_KING_PAIRS;
+        auto const begin = static_cast<std::uint64_t>(king_pairs.begin) * indices_per_king_pair;
+        auto const end = static_cast<std::uint64_t>(king_pairs.end) * indices_per_king_pair;
+        return {std::pair{begin, end}, std::pair{indices_per_side + begin, indices_per_side + end}};
+    }
+
+
+    ShardExchange::ShardExchange(
+        std::string directory,
+        std::string run_id,
+        int const shard,
+        int const num_shards,
+        std::chrono::seconds const timeout
+    ) : directory_{std::move(directory)}, run_id_{std::move(run_id)}, shard_{shard}, num_shards_{num_shards}, timeout_{timeout}, owners_(NUM_KING_PAIRS) {
+        if (num_shards < 1 or num_shards > NUM_KING_PAIRS or shard < 0 or shard >= num_shards) {
+            throw std::runtime_error("Invalid shard " + std::to_string(shard) + " of " + std::to_string(num_shards));
+        }
+        if (not is_valid_shard_run_id(run_id_)) {
+            throw std::runtime_error("Invalid shard run identifier '" + run_id_ + "'");
+        }
+        for (auto owner = 0; owner < num_shards; ++owner) {
+            auto const king_pairs = king_pair_range_of_shard(owner, num_shards);
+            std::fill(owners_.begin() + king_pairs.begin, owners_.begin() + king_pairs.end, owner);
+        }
+    }
+
+    auto ShardExchange::shard() const -> int {
+        return shard_;
+    }
+
+    auto ShardExchange::num_shards() const -> int {
+        return num_shards_;
+    }
+
+    auto ShardExchange::king_pairs() const -> KingPairRange {
+        return king_pair_range_of_shard(shard_, num_shards_);
+    }
+
+    auto ShardExchange::owner_of_king_pair(int const king_pair) const -> int {
+        return owners_[static_cast<std::size_t>(king_pair)];
+    }
+
+    auto ShardExchange::exchange(
+        std::string const& signature,
+        int const depth,
+        std::vector<ConfigBits> const& wins,
+        std::vector<std::vector<ConfigBits>> const& candidates
+    ) const -> ShardUpdates {
+        for (auto other = 0; other < num_shards_; ++other) {
+            if (other == shard_) continue;
+            write_atomically(delta_path(directory_, run_id_, signature, depth, shard_, other), [&](std::ofstream& file) {
+                write_config_bits(file, wins);
+                write_config_bits(file, candidates[static_cast<std::size_t>(other)]);
+            });
+        }
+
+        // each file is only read by the shard it was sent to, which removes it once read
+        auto updates = ShardUpdates{};
+        for (auto other = 0; other < num_shards_; ++other) {
+            if (other == shard_) continue;
+            auto const path = delta_path(directory_, run_id_, signature, depth, other, shard_);
+            wait_for_file(path, directory_, run_id_, timeout_);
+            {
+                auto file = std::ifstream(path, std::ios::binary);
+                read_config_bits(file, updates.wins);
+                read_config_bits(file, updates.candidates);
+                if (not file) {
+                    throw std::runtime_error(path.string() + " is truncated");
+                }
+            }
+            std::filesystem::remove(path);
+        }
+        return updates;
+    }
+
+    auto ShardExchange::write_table_part(DenseTable const& table_part) const -> void {
+        write_atomically(table_part_path(directory_, run_id_, table_part.signature, shard_), [&](std::ofstream& file) {
+            write_value(file, static_cast<std::int32_t>(num_shards_));
+            write_value(file, static_cast<std::int32_t>(table_part.max_depth_to_mate));
+            file.write(reinterpret_cast<char const*>(table_part.entries.data()), static_cast<std::streamsize>(table_part.entries.size()));
+        });
+    }
+
+    auto ShardExchange::read_table(std::string const& signature, int const max_depth_to_mate) const -> DenseTable {
+        return read_table_parts(directory_, run_id_, signature, max_depth_to_mate, num_shards_, timeout_);
+    }
+
+
+    auto solve_shard_of_signatures(
+        std::set<std::string> const& signatures,
+        int const max_depth_to_mate,
+        std::string const& directory,
+        std::string const& run_id,
+        int const shard,
+        int const num_shards,
+        std::chrono::seconds const timeout
+    ) -> void {
+        auto const exchange = ShardExchange(directory, run_id, shard, num_shards, timeout);
+        try {
+            solve_shard(signatures, max_depth_to_mate, exchange);
+        } catch (...) {
+            abort_sharded_solve(directory, run_id);
+            throw;
+        }
+    }
+
+    auto read_sharded_tables(
+        std::set<std::string> const& signatures,
+        int const max_depth_to_mate,
+        std::string const& directory,
+        std::string const& run_id,
+        int const num_shards,
+        std::chrono::seconds const timeout
+    ) -> std::map<std::string, DenseTable> {
+        if (not is_valid_shard_run_id(run_id)) {
+            throw std::runtime_error("Invalid shard run identifier '" + run_id + "'");
+        }
+
+        auto tables = std::map<std::string, DenseTable>{};
+        for (auto const& signature : signatures) {
+            auto const canonical_signature = signature_for_pieces(std::vector<char>{signature.begin(), signature.end()});
+            tables.emplace(canonical_signature, read_table_parts(directory, run_id, canonical_signature, max_depth_to_mate, num_shards, timeout));
+        }
+        return tables;
+    }
+
+    auto abort_sharded_solve(std::string const& directory, std::string const& run_id) -> void {
+        write_atomically(abort_path(directory, run_id), [](std::ofstream&) {});
+    }
+
+    auto clear_shard_directory(std::string const& directory, std::string const& run_id) -> void {
+        if (not std::filesystem::exists(directory)) return;
+
+        for (auto const& file : std::filesystem::directory_iterator(directory)) {
+            auto path = file.path();
+            if (path.extension() == TEMPORARY_EXTENSION) {
+                path.replace_extension();
+            }
+            if (not run_id.empty() and not path.filename().string().starts_with(run_id + ".")) continue;
+            if (path.extension() == SHARD_TABLE_EXTENSION or path.extension() == SHARD_DELTA_EXTENSION or path.extension() == SHARD_ABORT_EXTENSION) {
+                std::filesystem::remove(file.path());
+            }
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef COMP3821_PROJ_SHARDING_HEADER
+#define COMP3821_PROJ_SHARDING_HEADER
+
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <array>
+#include <utility>
+#include <cstdint>
+#include <chrono>
+#include "position_index.h"
+#include "king_tables.h"
+
+namespace tablebase {
+    // Shards own contiguous ranges of king pairs (see king_tables.h)
+    auto constexpr SHARD_TABLE_EXTENSION = ".shard";
+    auto constexpr SHARD_DELTA_EXTENSION = ".delta";
+    // Written by a shard (or the coordinator) which fails, so that the others stop waiting for it
+    auto constexpr SHARD_ABORT_EXTENSION = ".abort";
+    // How long to wait for the files of another shard before giving up on it
+    auto constexpr DEFAULT_SHARD_TIMEOUT = std::chrono::seconds(3600);
+
+    // A contiguous range [begin, end) of king pairs
+    struct KingPairRange {
+        int begin;
+        int end;
+    };
+
+    // Splits the king pairs into num_shards contiguous ranges of (nearly) equal size
+    auto king_pair_range_of_shard(int const shard, int const num_shards) -> KingPairRange;
+
+    // The indices of a signature's dense table whose king pair is in the range, which are one
+    // contiguous range [first, second) for each side to move (white first)
+    auto index_ranges_of_king_pairs(std::string const& signature, KingPairRange const king_pairs) -> std::array<std::pair<std::uint64_t, std::uint64_t>, 2>;
+
+    // A set of positions sharing the squares of every piece but the last one (see the bitbase
+    // solver), with a bit per square of the last piece
+    struct ConfigBits {
+        std::uint64_t config;
+        std::uint64_t bits;
+    };
+
+    // What one shard receives from the others at each depth
+    struct ShardUpdates {
+        // positions won at the previous depth, from every other shard
+        std::vector<ConfigBits> wins;
+        // predecessors of those wins which this shard owns
+        std::vector<ConfigBits> candidates;
+    };
+
+    // Whether the run identifier can name shard files, i.e. it is made of letters, digits, '-' and '_'
+    auto is_valid_shard_run_id(std::string const& run_id) -> bool;
+
+    // A run identifier which is unique to this process and time, for sharded solves whose workers
+    // are all started by this process
+    auto new_shard_run_id() -> std::string;
+
+    // Passes the updates of each depth between the shards of a signature through files in a
+    // directory that every shard can reach (e.g. a local directory for processes on one machine, or
+    // a shared file system across machines). Every file name starts with the run identifier shared
+    // by the shards of one solve, so files left behind by another (e.g. crashed) solve in the same
+    // directory are never read. Every file is written under a temporary name and
+    // renamed once complete, so a shard never reads a partially written file. Waiting for another
+    // shard throws std::runtime_error once the timeout passes or any shard has aborted the solve.
+    class ShardExchange {
+    public:
+        ShardExchange(
+            std::string directory,
+            std::string run_id,
+            int const shard,
+            int const num_shards,
+            std::chrono::seconds const timeout = DEFAULT_SHARD_TIMEOUT
+        );
+
+        auto shard() const -> int;
+        auto num_shards() const -> int;
+        auto king_pairs() const -> KingPairRange;
+        auto owner_of_king_pair(int const king_pair) const -> int;
+
+        // Sends this shard's wins to every other shard and each list of candidates (indexed by
+        // shard) to its owner, then waits for every other shard to do the same for this depth
+        auto exchange(
+            std::string const& signature,
+            int const depth,
+            std::vector<ConfigBits> const& wins,
+            std::vector<std::vector<ConfigBits>> const& candidates
+        ) const -> ShardUpdates;
+
+        // Writes this shard's part of a solved table, i.e. a table holding only the entries of
+        // index_ranges_of_king_pairs (concatenated)
+        auto write_table_part(DenseTable const& table_part) const -> void;
+
+        // Assembles the full table from the part written by every shard, waiting for any shard
+        // which has not written its part yet
+        auto read_table(std::string const& signature, int const max_depth_to_mate) const -> DenseTable;
+
+    private:
+        std::string directory_;
+        std::string run_id_;
+        int shard_;
+        int num_shards_;
+        std::chrono::seconds timeout_;
+        std::vector<int> owners_;
+    };
+
+    // Runs a single shard of a sharded solve (see solve_signature_shard_with_bitboards), solving
+    // the signatures from the fewest pieces upwards and writing its part of each table, which the
+    // other shards read back to resolve captures into smaller signatures. Every shard must be given
+    // the same signatures. If the shard fails, it aborts the solve before rethrowing the error.
+    auto solve_shard_of_signatures(
+        std::set<std::string> const& signatures,
+        int const max_depth_to_mate,
+        std::string const& directory,
+        std::string const& run_id,
+        int const shard,
+        int const num_shards,
+        std::chrono::seconds const timeout = DEFAULT_SHARD_TIMEOUT
+    ) -> void;
+
+    // Assembles the full tables written by every shard of a sharded solve into the directory,
+    // waiting (up to the timeout) for any shard which is still running
+    auto read_sharded_tables(
+        std::set<std::string> const& signatures,
+        int const max_depth_to_mate,
+        std::string const& directory,
+        std::string const& run_id,
+        int const num_shards,
+        std::chrono::seconds const timeout = DEFAULT_SHARD_TIMEOUT
+    ) -> std::map<std::string, DenseTable>;
+
+    // Marks the sharded solve in the directory as failed, which makes every shard waiting on
+    // another one throw instead
+    auto abort_sharded_solve(std::string const& directory, std::string const& run_id) -> void;
+
+    // Removes the files a sharded solve left in the directory, or the files of every solve if no
+    // run identifier is given
+    auto clear_shard_directory(std::string const& directory, std::string const& run_id = {}) -> void;
+}
+
+
+#endif // COMP3821_PROJ_SHARDING_HEADER
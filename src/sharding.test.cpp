@@ -0,0 +1,104 @@
+#include "./position_index.h"
+#include "./bitbase_solver.h"
+#include "./sharding.h"
+#include <catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <chrono>
+
+TEST_CASE("King pairs are split into contiguous shards") {
+    for (auto const num_shards : {1, 3, 7}) {
+        auto expected_begin = 0;
+        for (auto shard = 0; shard < num_shards; ++shard) {
+            auto const king_pairs = tablebase::king_pair_range_of_shard(shard, num_shards);
+            CHECK(king_pairs.begin == expected_begin);
+            CHECK(king_pairs.end > king_pairs.begin);
+            expected_begin = king_pairs.end;
+        }
+        CHECK(expected_begin == tablebase::NUM_KING_PAIRS);
+    }
+
+    // the king pair is the two squares after the side to move
+    auto const ranges = tablebase::index_ranges_of_king_pairs("kKR", tablebase::KingPairRange{64, 128});
+    auto const indexer = tablebase::PositionIndexer("kKR");
+    CHECK(indexer.squares_at(ranges[0].first) == std::vector<int>{1, 0, 0});
+    CHECK(indexer.squares_at(ranges[0].second - 1) == std::vector<int>{1, 63, 63});
+    CHECK(indexer.is_white_turn_at(ranges[0].first));
+    CHECK(not indexer.is_white_turn_at(ranges[1].first));
+    CHECK(ranges[1].second - ranges[1].first == ranges[0].second - ranges[0].first);
+}
+
+TEST_CASE("Sharded solves match solving in a single process") {
+    auto const directory = std::filesystem::temp_directory_path() / "sharding_test";
+    std::filesystem::create_directories(directory);
+    tablebase::clear_shard_directory(directory.string());
+
+    auto const signatures = std::set<std::string>{"kK", "kKR", "kKn", "kKRn"};
+    auto const max_depth_to_mate = 5;
+    auto const num_shards = 3;
+
+    // files a crashed solve left behind are ignored, as they belong to another run
+    auto const stale_files = {"previous.kKR.0.shard", "previous.kKR.1.0.1.delta", "previous.kKR.2.shard.tmp", "previous.abort"};
+    for (auto const* stale_file : stale_files) {
+        std::ofstream(directory / stale_file) << "stale";
+    }
+    auto const files_in_directory = [&directory] {
+        auto files = std::set<std::string>{};
+        for (auto const& file : std::filesystem::directory_iterator(directory)) {
+            files.insert(file.path().filename().string());
+        }
+        return files;
+    };
+
+    // as the coordinator does before starting its workers, which may share the directory with
+    // another solve that is still running
+    tablebase::clear_shard_directory(directory.string(), "current");
+    CHECK(files_in_directory() == std::set<std::string>(stale_files.begin(), stale_files.end()));
+
+    // threads stand in for the worker processes, as they only share the directory
+    auto shards = std::vector<std::thread>{};
+    for (auto shard = 0; shard < num_shards; ++shard) {
+        shards.emplace_back([&, shard] {
+            tablebase::solve_shard_of_signatures(signatures, max_depth_to_mate, directory.string(), "current", shard, num_shards);
+        });
+    }
+    for (auto& shard : shards) {
+        shard.join();
+    }
+
+    auto const sharded = tablebase::read_sharded_tables(signatures, max_depth_to_mate, directory.string(), "current", num_shards);
+    auto const expected = tablebase::solve_signatures_with_bitboards(signatures, max_depth_to_mate);
+    for (auto const& signature : signatures) {
+        CHECK(sharded.at(signature).entries == expected.at(signature).entries);
+    }
+
+    // every exchanged update is removed once it has been read
+    for (auto const& file : std::filesystem::directory_iterator(directory)) {
+        CHECK((file.path().extension() != tablebase::SHARD_DELTA_EXTENSION or file.path().filename().string().starts_with("previous.")));
+    }
+
+    // clearing a run only removes its own files
+    tablebase::clear_shard_directory(directory.string(), "current");
+    CHECK(files_in_directory() == std::set<std::string>(stale_files.begin(), stale_files.end()));
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Shards stop waiting for a missing shard") {
+    auto const directory = std::filesystem::temp_directory_path() / "sharding_timeout_test";
+    std::filesystem::create_directories(directory);
+    tablebase::clear_shard_directory(directory.string());
+
+    // shard 1 never runs, so shard 0 gives up on its first exchange and aborts the solve
+    auto const signatures = std::set<std::string>{"kK", "kKR"};
+    CHECK_THROWS_AS(tablebase::solve_shard_of_signatures(signatures, 3, directory.string(), "missing", 0, 2, std::chrono::seconds(1)), std::runtime_error);
+
+    // which makes everyone else waiting on the solve stop straight away
+    auto const started = std::chrono::steady_clock::now();
+    CHECK_THROWS_AS(tablebase::read_sharded_tables(signatures, 3, directory.string(), "missing", 2, std::chrono::seconds(60)), std::runtime_error);
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(10));
+
+    tablebase::clear_shard_directory(directory.string());
+    CHECK(std::filesystem::is_empty(directory));
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,156 @@
+#include <string>
+#include <vector>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#include "table_memory.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        auto constexpr MAX_NUMA_NODES = 1024;
+        auto constexpr BITS_PER_MASK_WORD = 8 * sizeof(unsigned long);
+
+        auto default_memory = std::atomic<TableMemory>{TableMemory{}};
+
+        auto round_up(std::size_t const value, std::size_t const multiple) -> std::size_t {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        // Maps length bytes aligned to a huge page, by over-mapping a huge page and trimming the rest
+        auto map_aligned(std::size_t const length) -> void* {
+            auto* const mapped = mmap(nullptr, length + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapped == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+
+            auto const begin = reinterpret_cast<std::uintptr_t>(mapped);
+            auto const aligned = round_up(begin, HUGE_PAGE_BYTES);
+            if (aligned > begin) {
+                munmap(mapped, aligned - begin);
+            }
+            auto const tail = begin + HUGE_PAGE_BYTES - aligned;
+            if (tail > 0) {
+                munmap(reinterpret_cast<void*>(aligned + length), tail);
+            }
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Reads the online NUMA nodes (e.g. "0-1,3") into a node mask
+        auto online_numa_nodes() -> std::vector<unsigned long> {
+            auto mask = std::vector<unsigned long>(MAX_NUMA_NODES / BITS_PER_MASK_WORD, 0);
+            auto file = std::ifstream("/sys/devices/system/node/online");
+            auto ranges = std::string{};
+            if (not std::getline(file, ranges)) {
+                mask[0] = 1;
+                return mask;
+            }
+
+            auto stream = std::stringstream(ranges);
+            auto range = std::string{};
+            while (std::getline(stream, range, ',')) {
+                auto const dash = range.find('-');
+                auto const first = std::stoi(range.substr(0, dash));
+                auto const last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+                for (auto node = first; node <= last and node < MAX_NUMA_NODES; ++node) {
+                    mask[static_cast<std::size_t>(node) / BITS_PER_MASK_WORD] |= 1UL << (static_cast<std::size_t>(node) % BITS_PER_MASK_WORD);
+                }
+            }
+            return mask;
+        }
+
+        // The placement only applies to pages which have not been touched yet. Failures (e.g. a
+        // kernel without NUMA support) leave the kernel's default placement.
+        auto interleave_over_numa_nodes(void* const pointer, std::size_t const length) -> void {
+            auto const nodes = online_numa_nodes();
+            syscall(SYS_mbind, pointer, length, MPOL_INTERLEAVE, nodes.data(), MAX_NUMA_NODES + 1, 0);
+        }
+    }
+
+
+    auto set_default_table_memory(TableMemory const memory) -> void {
+        default_memory.store(memory);
+    }
+
+    auto default_table_memory() -> TableMemory {
+        return default_memory.load();
+    }
+
+    auto allocate_table_memory(std::size_t const bytes, TableMemory const memory) -> void* {
+        if (bytes < HUGE_PAGE_BYTES) {
+            return ::operator new(bytes);
+        }
+
+        auto const length = round_up(bytes, HUGE_PAGE_BYTES);
+        auto* pointer = MAP_FAILED;
+        if (memory.huge_pages == HugePages::EXPLICIT) {
+            pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+
+        if (pointer == MAP_FAILED) {
+            pointer = map_aligned(length);
+            if (memory.huge_pages == HugePages::TRANSPARENT or memory.huge_pages == HugePages::EXPLICIT) {
+                madvise(pointer, length, MADV_HUGEPAGE);
+            } else if (memory.huge_pages == HugePages::OFF) {
+                madvise(pointer, length, MADV_NOHUGEPAGE);
+            }
+        }
+
+        if (memory.numa_placement == NumaPlacement::INTERLEAVE) {
+            interleave_over_numa_nodes(pointer, length);
+        }
+        return pointer;
+    }
+
+    auto free_table_memory(void* const pointer, std::size_t const bytes) -> void {
+        if (bytes < HUGE_PAGE_BYTES) {
+            ::operator delete(pointer);
+            return;
+        }
+        munmap(pointer, round_up(bytes, HUGE_PAGE_BYTES));
+    }
+
+    auto huge_pages_from_string(std::string const& value) -> std::optional<HugePages> {
+        if (value == "default") return HugePages::DEFAULT;
+        if (value == "off") return HugePages::OFF;
+        if (value == "transparent") return HugePages::TRANSPARENT;
+        if (value == "explicit") return HugePages::EXPLICIT;
+        return std::nullopt;
+    }
+
+    auto numa_placement_from_string(std::string const& value) -> std::optional<NumaPlacement> {
+        if (value == "local") return NumaPlacement::LOCAL;
+        if (value == "interleave") return NumaPlacement::INTERLEAVE;
+        return std::nullopt;
+    }
+
+    auto to_string(HugePages const huge_pages) -> std::string {
+        switch (huge_pages) {
+            case HugePages::OFF: return "off";
+            case HugePages::TRANSPARENT: return "transparent";
+            case HugePages::EXPLICIT: return "explicit";
+            default: return "default";
+        }
+    }
+
+    auto to_string(NumaPlacement const numa_placement) -> std::string {
+        return (numa_placement == NumaPlacement::INTERLEAVE) ? "interleave" : "local";
+    }
+
+    auto huge_page_bytes_in_use() -> std::uint64_t {
+        auto file = std::ifstream("/proc/self/smaps_rollup");
+        auto total_kilobytes = std::uint64_t{0};
+        auto line = std::string{};
+        while (std::getline(file, line)) {
+            if (line.starts_with("AnonHugePages:") or line.starts_with("Private_Hugetlb:") or line.starts_with("Shared_Hugetlb:")) {
+                total_kilobytes += std::stoull(line.substr(line.find(':') + 1));
+            }
+        }
+        return total_kilobytes * 1024;
+    }
+}
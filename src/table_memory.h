@@ -0,0 +1,103 @@
+#ifndef COMP3821_PROJ_TABLE_MEMORY_HEADER
+#define COMP3821_PROJ_TABLE_MEMORY_HEADER
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace tablebase {
+    // Tables are flat arrays indexed by position, so random probes and un-moves touch a different
+    // page almost every access. Once tables run to gigabytes, TLB misses dominate those accesses,
+    // which backing the tables with 2MB huge pages avoids.
+    enum class HugePages : std::uint8_t {
+        // whatever the system does for ordinary allocations
+        DEFAULT = 0,
+        // never use huge pages, even when transparent huge pages are enabled system-wide
+        OFF = 1,
+        // ask for transparent huge pages (madvise), which the kernel provides when it can
+        TRANSPARENT = 2,
+        // map pages from the explicitly reserved huge page pool (MAP_HUGETLB), falling back to
+        // transparent huge pages when the pool is empty
+        EXPLICIT = 3,
+    };
+
+    // Where the pages of a table are placed on machines with several NUMA nodes. LOCAL places
+    // each page on the node of the thread that first touches it (the kernel's default), which suits
+    // a table filled and used by one process, e.g. a shard's worker. INTERLEAVE spreads the pages
+    // over every node, which suits tables probed at random by threads on every node.
+    enum class NumaPlacement : std::uint8_t {
+        LOCAL = 0,
+        INTERLEAVE = 1,
+    };
+
+    struct TableMemory {
+        HugePages huge_pages = HugePages::DEFAULT;
+        NumaPlacement numa_placement = NumaPlacement::LOCAL;
+    };
+
+    // Allocations of at least this many bytes are mapped on their own (rounded up to whole huge
+    // pages and aligned to them), while smaller ones come from the ordinary heap
+    auto constexpr HUGE_PAGE_BYTES = std::size_t{2} << 20;
+
+    // The policy of allocators which were not given one, i.e. every table allocated during
+    // generation. This should be set before any tables are allocated.
+    auto set_default_table_memory(TableMemory const memory) -> void;
+    auto default_table_memory() -> TableMemory;
+
+    // Throws std::bad_alloc if the memory cannot be mapped. Memory is freed by its size alone, so it
+    // does not matter which policy it was allocated with.
+    auto allocate_table_memory(std::size_t const bytes, TableMemory const memory) -> void*;
+    auto free_table_memory(void* const pointer, std::size_t const bytes) -> void;
+
+    // Parses the values of the --huge-pages and --numa options, returning nullopt for unknown values
+    auto huge_pages_from_string(std::string const& value) -> std::optional<HugePages>;
+    auto numa_placement_from_string(std::string const& value) -> std::optional<NumaPlacement>;
+    auto to_string(HugePages const huge_pages) -> std::string;
+    auto to_string(NumaPlacement const numa_placement) -> std::string;
+
+    // Bytes of this process's memory currently backed by huge pages (transparent or explicit), or 0
+    // where the kernel does not report it
+    auto huge_page_bytes_in_use() -> std::uint64_t;
+
+    template <typename T>
+    class TableAllocator {
+    public:
+        using value_type = T;
+        // memory is freed the same way whatever the policy, so any allocator can free it
+        using is_always_equal = std::true_type;
+
+        TableAllocator() : memory_{default_table_memory()} {}
+        explicit TableAllocator(TableMemory const memory) : memory_{memory} {}
+        template <typename U>
+        TableAllocator(TableAllocator<U> const& other) : memory_{other.memory()} {}
+
+        auto allocate(std::size_t const n) -> T* {
+            return static_cast<T*>(allocate_table_memory(n * sizeof(T), memory_));
+        }
+
+        auto deallocate(T* const pointer, std::size_t const n) -> void {
+            free_table_memory(pointer, n * sizeof(T));
+        }
+
+        auto memory() const -> TableMemory {
+            return memory_;
+        }
+
+        template <typename U>
+        auto operator==(TableAllocator<U> const&) const -> bool {
+            return true;
+        }
+
+    private:
+        TableMemory memory_;
+    };
+
+    template <typename T>
+    using TableVector = std::vector<T, TableAllocator<T>>;
+}
+
+
+#endif // COMP3821_PROJ_TABLE_MEMORY_HEADER
@@ -0,0 +1,33 @@
+#include "./table_memory.h"
+#include <catch.hpp>
+#include <numeric>
+
+TEST_CASE("Tables can be allocated under every memory policy") {
+    for (auto const huge_pages : {tablebase::HugePages::DEFAULT, tablebase::HugePages::OFF, tablebase::HugePages::TRANSPARENT, tablebase::HugePages::EXPLICIT}) {
+        for (auto const numa_placement : {tablebase::NumaPlacement::LOCAL, tablebase::NumaPlacement::INTERLEAVE}) {
+            auto const memory = tablebase::TableMemory{huge_pages, numa_placement};
+
+            // explicit huge pages fall back to transparent ones when none are reserved
+            for (auto const size : {std::size_t{1000}, tablebase::HUGE_PAGE_BYTES, 3 * tablebase::HUGE_PAGE_BYTES + 5}) {
+                auto table = tablebase::TableVector<std::uint64_t>(size, 0, tablebase::TableAllocator<std::uint64_t>(memory));
+                CHECK(std::accumulate(table.begin(), table.end(), std::uint64_t{0}) == 0);
+                std::iota(table.begin(), table.end(), std::uint64_t{0});
+
+                // copies keep the policy of the table they were copied from
+                auto const copy = table;
+                CHECK(copy.get_allocator().memory().huge_pages == huge_pages);
+                CHECK(copy.back() == size - 1);
+
+                table.resize(size * 2, 1);
+                CHECK(table[size - 1] == size - 1);
+                CHECK(table.back() == 1);
+            }
+        }
+    }
+
+    CHECK(tablebase::huge_pages_from_string("transparent") == tablebase::HugePages::TRANSPARENT);
+    CHECK(tablebase::huge_pages_from_string(tablebase::to_string(tablebase::HugePages::OFF)) == tablebase::HugePages::OFF);
+    CHECK(not tablebase::huge_pages_from_string("on").has_value());
+    CHECK(tablebase::numa_placement_from_string("interleave") == tablebase::NumaPlacement::INTERLEAVE);
+    CHECK(not tablebase::numa_placement_from_string("remote").has_value());
+}
@@ -0,0 +1,91 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "table_verifier.h"
+
+namespace tablebase {
+    auto VerificationResult::merge(VerificationResult const& other) -> void {
+        positions_checked += other.positions_checked;
+        positions_unverifiable += other.positions_unverifiable;
+        inconsistencies.insert(inconsistencies.end(), other.inconsistencies.begin(), other.inconsistencies.end());
+    }
+
+    auto expected_depth_to_mate(
+        chess::Board& board,
+        std::map<std::string, DenseTable> const& tables,
+        int const max_depth_to_mate
+    ) -> std::optional<int> {
+        auto const isWhiteTurn = board.sideToMove() == chess::Color::WHITE;
+
+        if (board.isAttacked(board.kingSq(~board.sideToMove()), board.sideToMove())) return -1;
+
+        auto movelist = chess::Movelist();
+        chess::movegen::legalmoves(movelist, board);
+        if (movelist.empty()) {
+            return (not isWhiteTurn and board.inCheck()) ? 0 : -1;
+        }
+
+        auto const signature = signature_of_board(board);
+        auto best_depth_to_mate = -1;
+        for (auto const move : movelist) {
+            auto const isCapture = board.at(move.to()) != chess::Piece::NONE;
+            board.makeMove(move);
+            auto const successor_signature = isCapture ? signature_of_board(board) : signature;
+            auto const table = tables.find(successor_signature);
+            if (table == tables.end()) {
+                board.unmakeMove(move);
+                return std::nullopt;
+            }
+            auto const index = PositionIndexer(successor_signature).index_of_board(board);
+            board.unmakeMove(move);
+
+            auto const successor_depth_to_mate = depth_to_mate_for_entry(table->second.entries[*index]);
+            if (isWhiteTurn) {
+                if (successor_depth_to_mate >= 0 and (best_depth_to_mate < 0 or successor_depth_to_mate < best_depth_to_mate)) {
+                    best_depth_to_mate = successor_depth_to_mate;
+                }
+            } else {
+                // black escapes a forced win with this move
+                if (successor_depth_to_mate < 0) return -1;
+                best_depth_to_mate = std::max(best_depth_to_mate, successor_depth_to_mate);
+            }
+        }
+
+        if (best_depth_to_mate < 0 or best_depth_to_mate + 1 > max_depth_to_mate) return -1;
+        return best_depth_to_mate + 1;
+    }
+
+    auto verify_index_range(
+        std::string const& signature,
+        std::map<std::string, DenseTable> const& tables,
+        std::uint64_t const begin,
+        std::uint64_t const end
+    ) -> VerificationResult {
+        auto result = VerificationResult{};
+        auto const indexer = PositionIndexer(signature);
+        auto const& table = tables.at(indexer.signature());
+
+        for (auto index = begin; index < end; ++index) {
+            auto const stored_depth_to_mate = depth_to_mate_for_entry(table.entries[index]);
+            auto const FEN_string = indexer.FEN_at(index);
+            ++result.positions_checked;
+
+            if (not FEN_string) {
+                if (stored_depth_to_mate >= 0) {
+                    result.inconsistencies.emplace_back(Inconsistency{index, std::string{}, stored_depth_to_mate, -1});
+                }
+                continue;
+            }
+
+            auto board = chess::Board(*FEN_string);
+            auto const expected = expected_depth_to_mate(board, tables, table.max_depth_to_mate);
+            if (not expected) {
+                ++result.positions_unverifiable;
+            } else if (*expected != stored_depth_to_mate) {
+                result.inconsistencies.emplace_back(Inconsistency{index, *FEN_string, stored_depth_to_mate, *expected});
+            }
+        }
+
+        return result;
+    }
+}
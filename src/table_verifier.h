@@ -0,0 +1,56 @@
+#ifndef COMP3821_PROJ_TABLE_VERIFIER_HEADER
+#define COMP3821_PROJ_TABLE_VERIFIER_HEADER
+
+#include <vector>
+#include <string>
+#include <map>
+#include <optional>
+#include <cstdint>
+#include <chess.hpp>
+#include "position_index.h"
+
+namespace tablebase {
+    // A position whose stored depth to mate disagrees with the one recomputed from its successors
+    struct Inconsistency {
+        std::uint64_t index;
+        std::string FEN_string;
+        int stored_depth_to_mate;
+        int expected_depth_to_mate;
+    };
+
+    struct VerificationResult {
+        std::uint64_t positions_checked = 0;
+        // positions with a successor (after a capture) whose signature has no table
+        std::uint64_t positions_unverifiable = 0;
+        std::vector<Inconsistency> inconsistencies;
+
+        auto merge(VerificationResult const& other) -> void;
+    };
+
+    // Recomputes the depth to mate of the board from its successors with one move of forward move
+    // generation, following the definition used by our generator: checkmates of black are 0, white
+    // picks the quickest mate among its moves, black is only lost if every move is (and then picks
+    // the slowest mate), and illegal positions (where the player who just moved is in check) are
+    // never wins. Depths beyond max_depth_to_mate are not forced wins (-1).
+    // Returns nullopt if a successor's signature has no table.
+    auto expected_depth_to_mate(
+        chess::Board& board,
+        std::map<std::string, DenseTable> const& tables,
+        int const max_depth_to_mate
+    ) -> std::optional<int>;
+
+    // Checks every index in [begin, end) of the table (which must be in tables alongside the tables
+    // of every signature reachable from it by a capture). This covers wins without a successor one
+    // ply closer to mate, losses for black with an escape, checkmates that are not checkmates and
+    // wins that are missing from the table, along with entries for overlapping or non-canonical
+    // placements that should have been left empty.
+    auto verify_index_range(
+        std::string const& signature,
+        std::map<std::string, DenseTable> const& tables,
+        std::uint64_t const begin,
+        std::uint64_t const end
+    ) -> VerificationResult;
+}
+
+
+#endif // COMP3821_PROJ_TABLE_VERIFIER_HEADER
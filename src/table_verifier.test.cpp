@@ -0,0 +1,50 @@
+#include "./test_fixtures.h"
+#include "./position_index.h"
+#include "./table_verifier.h"
+#include <catch.hpp>
+#include <chess.hpp>
+#include <set>
+
+TEST_CASE("Verifying tables against forward move generation") {
+    auto const& tablebase = fixtures::generated_tablebase(6, 3, std::vector<char>{{'k', 'K', 'R'}});
+    auto tables = tablebase::dense_tables_from_tablebase(tablebase, 6);
+    // kK has no forced wins, so the conversion does not create a table for it
+    tables.emplace("kK", tablebase::DenseTable{"kK", 6, tablebase::TableVector<std::uint8_t>(tablebase::PositionIndexer("kK").size(), tablebase::NOT_A_FORCED_WIN)});
+
+    auto const indexer = tablebase::PositionIndexer("kKR");
+    auto const size = indexer.size();
+
+    SECTION("Generated tables are consistent") {
+        auto const result = tablebase::verify_index_range("kKR", tables, 0, size);
+        CHECK(result.positions_checked == size);
+        CHECK(result.positions_unverifiable == 0);
+        CHECK(result.inconsistencies.empty());
+    }
+
+    SECTION("Incorrect depths and missing wins are found") {
+        // mate in 1 for white stored as mate in 3
+        auto const mate_in_one = *indexer.index_of_FEN("5k2/8/5K2/8/8/8/8/3R4 w - - 0 1");
+        REQUIRE(tables.at("kKR").entries[mate_in_one] == 2);
+        tables.at("kKR").entries[mate_in_one] = 4;
+
+        // a checkmate that is missing from the table
+        auto const checkmate = *indexer.index_of_FEN("3R1k2/8/5K2/8/8/8/8/8 b - - 0 1");
+        REQUIRE(tables.at("kKR").entries[checkmate] == 1);
+        tables.at("kKR").entries[checkmate] = tablebase::NOT_A_FORCED_WIN;
+
+        auto const result = tablebase::verify_index_range("kKR", tables, 0, size);
+        auto found = std::set<std::uint64_t>{};
+        for (auto const& inconsistency : result.inconsistencies) {
+            found.insert(inconsistency.index);
+        }
+        CHECK(found.contains(mate_in_one));
+        CHECK(found.contains(checkmate));
+    }
+
+    SECTION("Positions depending on a missing table cannot be verified") {
+        tables.erase("kK");
+        auto const result = tablebase::verify_index_range("kKR", tables, 0, size);
+        CHECK(result.positions_unverifiable > 0);
+        CHECK(result.inconsistencies.empty());
+    }
+}
@@ -0,0 +1,191 @@
+#include <iostream>
+#include <chess.hpp>
+#include "./helper.h"
+#include "./compressed_tablebase.h"
+#include "./game_analysis.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <optional>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+
+// Games are handed to the probing workers in batches to keep the queue's locking off the hot path
+auto constexpr GAMES_PER_BATCH = 256;
+// Number of batches the parser may run ahead of the workers, which bounds memory use when the
+// workers cannot keep up with the parser
+auto constexpr MAX_QUEUED_BATCHES = 64;
+
+namespace {
+    // A blocking queue with a fixed capacity shared between the parser (the single producer) and
+    // the probing workers (the consumers)
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(std::size_t const capacity) : capacity_{capacity} {}
+
+        // Blocks while the queue is full
+        auto push(T item) -> void {
+            auto lock = std::unique_lock(mutex_);
+            not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+            items_.emplace_back(std::move(item));
+            not_empty_.notify_one();
+        }
+
+        // Blocks while the queue is empty, returning nullopt once it is empty and closed
+        auto pop() -> std::optional<T> {
+            auto lock = std::unique_lock(mutex_);
+            not_empty_.wait(lock, [this] { return not items_.empty() or closed_; });
+            if (items_.empty()) return std::nullopt;
+
+            auto item = std::move(items_.front());
+            items_.pop_front();
+            not_full_.notify_one();
+            return item;
+        }
+
+        // Called by the producer once nothing more will be pushed
+        auto close() -> void {
+            auto lock = std::unique_lock(mutex_);
+            closed_ = true;
+            not_empty_.notify_all();
+        }
+
+    private:
+        std::size_t capacity_;
+        std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+        std::deque<T> items_;
+        bool closed_ = false;
+    };
+}
+
+// This program streams a PGN file (of any size) through the tablebase, grading every move played
+// from a position whose material is covered by a directory of compressed tables (as written by
+// ./run_engine --compressed-output). A single thread parses games while a pool of workers replays
+// and probes them.
+int main(int argc, char** argv) {
+    auto [positional_arguments, options] = helper::parse_command_line(argc, argv);
+
+    if (positional_arguments.size() < 2) {
+        std::cout << "Usage is:\n"
+            << "./tb_analyze     <string>compressed_table_directory     <string>pgn_file    [options]\n\n"
+            << "\tEvery move played from a position with at most as many pieces as the largest table "
+            << "(and no pawns) is graded against the tablebase, with statistics reported per "
+            << "signature.\n\n"
+            << "\tOptions:\n"
+            << "\t--threads=<int> number of probing workers (defaults to the number of hardware "
+            << "threads).\n\n"
+            << "\t--csv=<path> additionally writes one row per graded move to the given file.\n\n"
+            ;
+        return 0;
+    }
+
+    auto const compressed_tablebase = tablebase::CompressedTablebase(positional_arguments[0]);
+    auto max_pieces_covered = 0;
+    for (auto const& signature : compressed_tablebase.signatures()) {
+        max_pieces_covered = std::max(max_pieces_covered, static_cast<int>(signature.size()));
+    }
+    if (max_pieces_covered == 0) {
+        std::cout << "Error: no compressed tables were found in " << positional_arguments[0] << ".\n";
+        return 1;
+    }
+
+    auto pgn_file = std::ifstream(positional_arguments[1]);
+    if (not pgn_file) {
+        std::cout << "Error: could not open " << positional_arguments[1] << ".\n";
+        return 1;
+    }
+
+    auto const num_threads = options.contains("threads")
+        ? std::max(1, std::stoi(options["threads"]))
+        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    auto csv_file = std::ofstream{};
+    auto csv_mutex = std::mutex{};
+    if (options.contains("csv")) {
+        csv_file.open(options["csv"]);
+        csv_file << "game,ply,fen,move,signature,outcome,depth_to_mate,grade\n";
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    auto queue = BoundedQueue<std::vector<tablebase::Game>>(MAX_QUEUED_BATCHES);
+    auto results = std::vector<tablebase::AnalysisResult>(static_cast<std::size_t>(num_threads));
+
+    auto workers = std::vector<std::thread>{};
+    for (auto i = 0; i < num_threads; ++i) {
+        workers.emplace_back([&, i] {
+            auto& result = results[static_cast<std::size_t>(i)];
+            auto csv_rows = std::string{};
+            while (auto batch = queue.pop()) {
+                for (auto const& game : *batch) {
+                    tablebase::analyze_game(compressed_tablebase, max_pieces_covered, game, result, csv_file.is_open() ? &csv_rows : nullptr);
+                }
+
+                if (not csv_rows.empty()) {
+                    auto lock = std::unique_lock(csv_mutex);
+                    csv_file << csv_rows;
+                    csv_rows.clear();
+                }
+            }
+        });
+    }
+
+    // games are collected into batches for the workers
+    auto batch = std::vector<tablebase::Game>{};
+    auto collector = tablebase::GameCollector([&queue, &batch](tablebase::Game game) {
+        batch.emplace_back(std::move(game));
+        if (batch.size() >= GAMES_PER_BATCH) {
+            queue.push(std::move(batch));
+            batch = std::vector<tablebase::Game>{};
+        }
+    });
+    // the parser's read buffer is too large for the stack
+    auto parser = std::make_unique<chess::pgn::StreamParser<>>(pgn_file);
+    auto const parser_error = parser->readGames(collector);
+    if (not batch.empty()) {
+        queue.push(std::move(batch));
+    }
+    queue.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    auto const elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto total = tablebase::AnalysisResult{};
+    for (auto const& result : results) {
+        total.merge(result);
+    }
+
+    if (parser_error.hasError()) {
+        std::cout << "Warning: parsing stopped early (" << parser_error.message() << ").\n";
+    }
+    std::cout << "Analysed " << total.games << " games (" << total.moves_replayed << " moves) in "
+        << elapsed_seconds << "s, " << (static_cast<double>(total.games) / elapsed_seconds)
+        << " games/sec with " << num_threads << " workers. " << total.unparsable_games
+        << " games contained moves that could not be parsed.\n\n";
+
+    std::cout << "signature,positions,forced_wins,forced_losses";
+    for (auto const grade : {tablebase::Grade::OPTIMAL, tablebase::Grade::SUBOPTIMAL, tablebase::Grade::WIN_THROWN_AWAY, tablebase::Grade::BLUNDER, tablebase::Grade::UNKNOWN}) {
+        std::cout << "," << tablebase::to_string(grade);
+    }
+    std::cout << "\n";
+    for (auto const& [signature, stats] : total.stats) {
+        std::cout << signature << "," << stats.positions << "," << stats.forced_wins << "," << stats.forced_losses;
+        for (auto const grade : {tablebase::Grade::OPTIMAL, tablebase::Grade::SUBOPTIMAL, tablebase::Grade::WIN_THROWN_AWAY, tablebase::Grade::BLUNDER, tablebase::Grade::UNKNOWN}) {
+            auto const count = stats.grades.find(grade);
+            std::cout << "," << ((count == stats.grades.end()) ? 0 : count->second);
+        }
+        std::cout << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include <iostream>
+#include <chess.hpp>
+#include "./helper.h"
+#include "./position_index.h"
+#include "./compressed_tablebase.h"
+#include "./table_memory.h"
+#include "./tbprobe.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <filesystem>
+
+// Number of random positions sampled from each table when none is provided
+auto constexpr DEFAULT_NUM_PROBES = 100000;
+
+namespace {
+    struct ProbeSet {
+        std::string description;
+        std::vector<chess::Board> boards;
+    };
+
+    // Times a pass over every board in the probe set, returning the mean nanoseconds per probe
+    auto time_probes(tablebase::CompressedTablebase const& compressed_tablebase, ProbeSet const& probe_set, long long& checksum) -> double {
+        auto const start = std::chrono::steady_clock::now();
+        for (auto const& board : probe_set.boards) {
+            checksum += compressed_tablebase.get_depth_to_mate_for_board(board);
+        }
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / static_cast<double>(probe_set.boards.size());
+    }
+
+    auto position_of_board(chess::Board const& board) -> tbprobe_position {
+        return tbprobe_position{
+            board.us(chess::Color::WHITE).getBits(),
+            board.us(chess::Color::BLACK).getBits(),
+            board.pieces(chess::PieceType::KING).getBits(),
+            board.pieces(chess::PieceType::QUEEN).getBits(),
+            board.pieces(chess::PieceType::ROOK).getBits(),
+            board.pieces(chess::PieceType::BISHOP).getBits(),
+            board.pieces(chess::PieceType::KNIGHT).getBits(),
+            board.pieces(chess::PieceType::PAWN).getBits(),
+            board.sideToMove() == chess::Color::WHITE
+        };
+    }
+
+    auto nanoseconds_per(std::chrono::steady_clock::time_point const start, std::size_t const count) -> double {
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / static_cast<double>(count);
+    }
+
+    // Times the two places where the allocation of large tables matters, under one memory policy:
+    // random reads of the largest table once decompressed (as during generation and verification),
+    // and probes of every table held resident by the tbprobe library
+    auto report_table_memory(
+        std::string const& directory,
+        std::string const& largest_table_path,
+        tablebase::TableMemory const memory,
+        std::vector<tbprobe_position> const& positions,
+        long long& checksum
+    ) -> void {
+        auto const huge_page_bytes_before = tablebase::huge_page_bytes_in_use();
+
+        tablebase::set_default_table_memory(memory);
+        auto const dense_table = tablebase::CompressedTable(largest_table_path).decompress_all();
+        auto random_engine = std::mt19937_64(3821);
+        auto distribution = std::uniform_int_distribution<std::uint64_t>(0, dense_table.entries.size() - 1);
+        auto indices = std::vector<std::uint64_t>(std::max<std::size_t>(positions.size(), 1) * 16);
+        for (auto& index : indices) {
+            index = distribution(random_engine);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (auto const index : indices) {
+            checksum += dense_table.entries[index];
+        }
+        auto const dense_ns = nanoseconds_per(start, indices.size());
+
+        auto const options = tbprobe_options{static_cast<int>(memory.huge_pages), static_cast<int>(memory.numa_placement)};
+        char error[256] = {};
+        auto* const probe = tbprobe_open_with_options(directory.c_str(), &options, error, sizeof(error));
+        if (probe == nullptr) {
+            std::cout << "Unable to open " << directory << " with tbprobe: " << error << "\n";
+            return;
+        }
+        start = std::chrono::steady_clock::now();
+        for (auto const& position : positions) {
+            checksum += tbprobe_dtm(probe, &position);
+        }
+        auto const resident_ns = nanoseconds_per(start, std::max<std::size_t>(positions.size(), 1));
+
+        std::cout << "--huge-pages=" << tablebase::to_string(memory.huge_pages) << " --numa=" << tablebase::to_string(memory.numa_placement) << ": "
+            << dense_ns << " ns/read of " << dense_table.signature << " (" << dense_table.entries.size() << " bytes), "
+            << resident_ns << " ns/probe through tbprobe, "
+            << (tablebase::huge_page_bytes_in_use() - std::min(huge_page_bytes_before, tablebase::huge_page_bytes_in_use())) / 1024 << " kB of huge pages\n";
+        tbprobe_close(probe);
+    }
+}
+
+// This program benchmarks probing a directory of compressed tables (as written by
+// ./run_engine --compressed-output), separately timing positions whose player to move was stored
+// and positions which have to be resolved by probing their successors
+int main(int argc, char** argv) {
+    auto [positional_arguments, options] = helper::parse_command_line(argc, argv);
+
+    if (positional_arguments.empty()) {
+        std::cout << "Usage is:\n"
+            << "./tb_bench     <string>compressed_table_directory     <optional int>num_probes_per_table    [options]\n\n"
+            << "\tnum_probes_per_table random legal positions are sampled from each table in the "
+            << "directory and probed twice, once with a cold block cache and once with a warm one.\n\n"
+            << "\tThe largest table is then decompressed and read at random, and the directory is "
+            << "probed through tbprobe, once for each huge page setting in "
+            << "--huge-pages=<comma separated list of default|off|transparent|explicit> (defaults to "
+            << "off,transparent,explicit), with the pages placed by --numa=<local|interleave>.\n\n"
+            ;
+        return 0;
+    }
+
+    auto const directory = positional_arguments[0];
+    auto const num_probes = (positional_arguments.size() >= 2) ? std::stoi(positional_arguments[1]) : DEFAULT_NUM_PROBES;
+
+    auto huge_page_settings = std::vector<tablebase::HugePages>{};
+    auto huge_pages_stream = std::stringstream(options.contains("huge-pages") ? options["huge-pages"] : std::string{"off,transparent,explicit"});
+    for (auto value = std::string{}; std::getline(huge_pages_stream, value, ',');) {
+        auto const huge_pages = tablebase::huge_pages_from_string(value);
+        if (not huge_pages) {
+            std::cout << "Error: --huge-pages values must be one of default, off, transparent or explicit.\n";
+            return 1;
+        }
+        huge_page_settings.push_back(*huge_pages);
+    }
+    auto const numa_placement = tablebase::numa_placement_from_string(options.contains("numa") ? options["numa"] : std::string{"local"});
+    if (not numa_placement) {
+        std::cout << "Error: --numa must be one of local or interleave.\n";
+        return 1;
+    }
+    auto largest_table_path = std::string{};
+    auto largest_table_size = std::uint64_t{0};
+
+    auto random_engine = std::mt19937_64(3821);
+    auto stored_probes = ProbeSet{"stored side to move", {}};
+    auto resolved_probes = ProbeSet{"resolved by successors", {}};
+
+    for (auto const& file : std::filesystem::directory_iterator(directory)) {
+        if (file.path().extension() != tablebase::COMPRESSED_TABLE_EXTENSION) continue;
+
+        auto const table = tablebase::CompressedTable(file.path().string());
+        auto const indexer = tablebase::PositionIndexer(table.signature());
+        auto distribution = std::uniform_int_distribution<std::uint64_t>(0, indexer.size() - 1);
+
+        for (auto sampled = 0; sampled < num_probes;) {
+            auto const index = distribution(random_engine);
+            auto const FEN_string = indexer.FEN_at(index);
+            if (not FEN_string) continue;
+
+            // skip positions where the player who just moved is in check
+            auto board = chess::Board(*FEN_string);
+            if (board.isAttacked(board.kingSq(~board.sideToMove()), board.sideToMove())) continue;
+
+            (table.stores_index(index) ? stored_probes : resolved_probes).boards.emplace_back(board);
+            ++sampled;
+        }
+
+        std::cout << "Sampled " << num_probes << " positions from " << table.signature() << " ("
+            << table.compressed_size() << " bytes compressed).\n";
+        if (table.size() > largest_table_size) {
+            largest_table_size = table.size();
+            largest_table_path = file.path().string();
+        }
+    }
+
+    auto checksum = 0LL;
+    auto const compressed_tablebase = tablebase::CompressedTablebase(directory);
+    for (auto const& probe_set : {stored_probes, resolved_probes}) {
+        if (probe_set.boards.empty()) continue;
+
+        auto const cold_ns = time_probes(compressed_tablebase, probe_set, checksum);
+        auto const warm_ns = time_probes(compressed_tablebase, probe_set, checksum);
+        std::cout << probe_set.description << ": " << probe_set.boards.size() << " probes, "
+            << cold_ns << " ns/probe (cold cache), " << warm_ns << " ns/probe (warm cache)\n";
+    }
+
+    std::cout << "Block cache hits: " << compressed_tablebase.cache().hits()
+        << ", misses: " << compressed_tablebase.cache().misses()
+        << " (checksum " << checksum << ")\n";
+
+    if (not largest_table_path.empty()) {
+        auto positions = std::vector<tbprobe_position>{};
+        for (auto const& board : stored_probes.boards) {
+            positions.push_back(position_of_board(board));
+        }
+        for (auto const huge_pages : huge_page_settings) {
+            report_table_memory(directory, largest_table_path, tablebase::TableMemory{huge_pages, *numa_placement}, positions, checksum);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include <iostream>
+#include <chess.hpp>
+#include "./helper.h"
+#include "./position_index.h"
+#include "./compressed_tablebase.h"
+#include "./table_verifier.h"
+#include "./corpus.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+// Indices are handed out to the workers in chunks of this size
+auto constexpr INDICES_PER_CHUNK = std::uint64_t{1} << 14;
+// Number of inconsistencies printed for each signature
+auto constexpr DEFAULT_MAX_REPORTED = 10;
+
+namespace {
+    // Runs a function over [begin, end) split into chunks across the worker threads, printing the
+    // progress once a second, and merges the results of every chunk
+    auto parallel_over_indices(
+        std::string const& description,
+        std::uint64_t const begin,
+        std::uint64_t const end,
+        int const num_threads,
+        std::function<tablebase::VerificationResult(std::uint64_t, std::uint64_t)> const& process_chunk
+    ) -> tablebase::VerificationResult {
+        auto next_chunk_begin = std::atomic<std::uint64_t>{begin};
+        auto indices_done = std::atomic<std::uint64_t>{0};
+        auto result = tablebase::VerificationResult{};
+        auto result_mutex = std::mutex{};
+
+        auto workers = std::vector<std::thread>{};
+        for (auto i = 0; i < num_threads; ++i) {
+            workers.emplace_back([&] {
+                auto worker_result = tablebase::VerificationResult{};
+                for (auto chunk_begin = next_chunk_begin.fetch_add(INDICES_PER_CHUNK); chunk_begin < end; chunk_begin = next_chunk_begin.fetch_add(INDICES_PER_CHUNK)) {
+                    auto const chunk_end = std::min(end, chunk_begin + INDICES_PER_CHUNK);
+                    worker_result.merge(process_chunk(chunk_begin, chunk_end));
+                    indices_done += chunk_end - chunk_begin;
+                }
+
+                auto const lock = std::lock_guard(result_mutex);
+                result.merge(worker_result);
+            });
+        }
+
+        auto const start = std::chrono::steady_clock::now();
+        auto const total = end - begin;
+        // polled more often than printed, so that finishing is noticed quickly
+        auto last_print = start;
+        while (indices_done < total) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            auto const now = std::chrono::steady_clock::now();
+            if (now - last_print < std::chrono::seconds(1) or indices_done >= total) continue;
+            last_print = now;
+
+            auto const elapsed = std::chrono::duration<double>(now - start).count();
+            std::cout << "\r" << description << ": " << (100 * indices_done / std::max<std::uint64_t>(total, 1))
+                << "% (" << static_cast<std::uint64_t>(static_cast<double>(indices_done) / elapsed) << " positions/s)   " << std::flush;
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        std::cout << "\r" << description << ": done in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s.            \n";
+
+        return result;
+    }
+
+    // Tables that store both sides are decompressed directly, while the side which was not stored
+    // is recomputed from its successors in the same way probes resolve it (which requires the tables
+    // of every capture to already be loaded)
+    auto load_table(
+        tablebase::CompressedTable const& compressed_table,
+        std::map<std::string, tablebase::DenseTable>& tables,
+        int const num_threads
+    ) -> void {
+        auto& table = tables[compressed_table.signature()] = compressed_table.decompress_all();
+        if (compressed_table.stored_sides() == tablebase::StoredSides::BOTH) return;
+
+        auto const half = table.entries.size() / 2;
+        auto const resolved_begin = compressed_table.stores_index(0) ? half : 0;
+        auto const indexer = tablebase::PositionIndexer(table.signature);
+
+        parallel_over_indices("Resolving unstored side of " + table.signature, resolved_begin, resolved_begin + half, num_threads, [&](std::uint64_t const begin, std::uint64_t const end) {
+            for (auto index = begin; index < end; ++index) {
+                auto const FEN_string = indexer.FEN_at(index);
+                if (not FEN_string) continue;
+
+                auto board = chess::Board(*FEN_string);
+                auto const depth_to_mate = tablebase::expected_depth_to_mate(board, tables, table.max_depth_to_mate);
+                if (depth_to_mate and *depth_to_mate >= 0) {
+                    table.entries[index] = static_cast<std::uint8_t>(*depth_to_mate + 1);
+                }
+            }
+            return tablebase::VerificationResult{};
+        });
+    }
+}
+
+// This program checks every position of a directory of compressed tables (as written by
+// ./run_engine --compressed-output) against one ply of forward move generation, in parallel
+int main(int argc, char** argv) {
+    auto [positional_arguments, options] = helper::parse_command_line(argc, argv);
+
+    if (positional_arguments.size() < 1) {
+        std::cout << "Usage is:\n"
+            << "./tb_verify     <string>compressed_table_directory    [options]\n\n"
+            << "\tRecomputes the depth to mate of every position in every table from its successors, "
+            << "reporting any position where it disagrees with the stored value. Tables of every "
+            << "signature reachable by captures must be in the same directory, generated with the "
+            << "same max_depth_to_mate.\n\n"
+            << "\tOptions:\n"
+            << "\t--threads=<int> number of worker threads (defaults to the number of hardware threads).\n\n"
+            << "\t--signature=<string> only verifies the given signature, e.g. kKQr.\n\n"
+            << "\t--max-reported=<int> number of inconsistencies printed per signature (defaults to "
+            << DEFAULT_MAX_REPORTED << ").\n\n"
+            ;
+        return 0;
+    }
+
+    auto const directory = std::filesystem::path(positional_arguments[0]);
+    auto const num_threads = options.contains("threads")
+        ? std::max(1, std::stoi(options["threads"]))
+        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    auto const max_reported = options.contains("max-reported") ? std::stoi(options["max-reported"]) : DEFAULT_MAX_REPORTED;
+
+    auto compressed_tables = std::map<std::string, std::unique_ptr<tablebase::CompressedTable>>{};
+    for (auto const& file : std::filesystem::directory_iterator(directory)) {
+        if (file.path().extension() != tablebase::COMPRESSED_TABLE_EXTENSION) continue;
+        auto table = std::make_unique<tablebase::CompressedTable>(file.path().string());
+        compressed_tables.emplace(table->signature(), std::move(table));
+    }
+
+    // smaller signatures are verified first, since larger signatures depend on them through captures
+    auto signatures = std::vector<std::string>{};
+    for (auto const& [signature, table] : compressed_tables) {
+        if (not options.contains("signature") or tablebase::signature_for_pieces(std::vector<char>{options["signature"].begin(), options["signature"].end()}) == signature) {
+            signatures.emplace_back(signature);
+        }
+    }
+    std::stable_sort(signatures.begin(), signatures.end(), [](std::string const& lhs, std::string const& rhs) {
+        return lhs.size() < rhs.size();
+    });
+    if (signatures.empty()) {
+        std::cout << "Error: no tables to verify were found in " << directory.string() << ".\n";
+        return 1;
+    }
+
+    auto tables = std::map<std::string, tablebase::DenseTable>{};
+    auto total_inconsistencies = std::uint64_t{0};
+    for (auto i = std::size_t{0}; i < signatures.size(); ++i) {
+        auto const& signature = signatures[i];
+        auto const reachable = tablebase::signatures_reachable_by_captures(signature);
+
+        // only the tables which are reachable through captures from a signature which is yet to be
+        // verified are kept in memory
+        auto still_needed = std::set<std::string>{};
+        for (auto j = i; j < signatures.size(); ++j) {
+            auto const reachable_later = tablebase::signatures_reachable_by_captures(signatures[j]);
+            still_needed.insert(reachable_later.begin(), reachable_later.end());
+        }
+        std::erase_if(tables, [&still_needed](auto const& table) { return not still_needed.contains(table.first); });
+
+        auto reachable_by_size = std::vector<std::string>{reachable.begin(), reachable.end()};
+        std::stable_sort(reachable_by_size.begin(), reachable_by_size.end(), [](std::string const& lhs, std::string const& rhs) {
+            return lhs.size() < rhs.size();
+        });
+        for (auto const& reachable_signature : reachable_by_size) {
+            if (tables.contains(reachable_signature) or not compressed_tables.contains(reachable_signature)) continue;
+            load_table(*compressed_tables.at(reachable_signature), tables, num_threads);
+        }
+
+        // for tables storing a single side, only the stored side is verified, as the other side was
+        // recomputed from it while loading
+        auto const& compressed_table = *compressed_tables.at(signature);
+        auto const half = compressed_table.size() / 2;
+        auto const begin = compressed_table.stores_index(0) ? 0 : half;
+        auto const end = compressed_table.stores_index(half) ? compressed_table.size() : half;
+
+        auto const result = parallel_over_indices("Verifying " + signature, begin, end, num_threads, [&](std::uint64_t const chunk_begin, std::uint64_t const chunk_end) {
+            return tablebase::verify_index_range(signature, tables, chunk_begin, chunk_end);
+        });
+
+        std::cout << signature << ": " << result.positions_checked << " positions checked, "
+            << result.inconsistencies.size() << " inconsistencies";
+        if (result.positions_unverifiable) {
+            std::cout << ", " << result.positions_unverifiable << " positions could not be verified "
+                << "as a table reachable through captures is missing";
+        }
+        std::cout << ".\n";
+
+        auto reported = result.inconsistencies;
+        std::sort(reported.begin(), reported.end(), [](auto const& lhs, auto const& rhs) { return lhs.index < rhs.index; });
+        for (auto i = 0; i < std::min(max_reported, static_cast<int>(reported.size())); ++i) {
+            std::cout << "\tindex " << reported[i].index << " (" << (reported[i].FEN_string.empty() ? "invalid placement" : reported[i].FEN_string)
+                << "): stored " << reported[i].stored_depth_to_mate << ", expected " << reported[i].expected_depth_to_mate << "\n";
+        }
+        total_inconsistencies += result.inconsistencies.size();
+    }
+
+    std::cout << "Verified " << signatures.size() << " signatures, " << total_inconsistencies << " inconsistencies in total.\n";
+    return (total_inconsistencies == 0) ? 0 : 1;
+}
@@ -0,0 +1,336 @@
+#include <vector>
+#include <string>
+#include <map>
+#include <array>
+#include <string_view>
+#include <stdexcept>
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <chess.hpp>
+#include "tbprobe.h"
+#include "position_index.h"
+#include "compressed_tablebase.h"
+#include "wdl_bitbase.h"
+#include "table_memory.h"
+
+// Everything is loaded by tbprobe_open and only read afterwards
+struct tbprobe_tablebase {
+    struct LoadedTable {
+        tablebase::PositionIndexer indexer;
+        std::unique_ptr<tablebase::CompressedTable> table;
+        tablebase::TableVector<std::uint8_t> encoded_blocks;
+    };
+
+    struct LoadedBitbase {
+        tablebase::PositionIndexer indexer;
+        tablebase::WDLBitbase bitbase;
+    };
+
+    std::map<std::string, LoadedTable> tables;
+    std::map<std::string, LoadedBitbase> bitbases;
+};
+
+// Private functions and constants/magic numbers
+namespace {
+    // (piece, square) pairs as taken by PositionIndexer::index_of_placement
+    struct Placement {
+        std::vector<std::pair<char, int>> pieces;
+        bool isWhiteTurn;
+    };
+
+    auto constexpr PIECE_TYPES = std::string_view{"kqrbnp"};
+
+    auto flipped_colour(char const piece) -> char {
+        return static_cast<char>(std::isupper(piece) ? std::tolower(piece) : std::toupper(piece));
+    }
+
+    // Returns nullopt unless every occupied square holds exactly one piece of exactly one colour
+    auto placement_of_position(tbprobe_position const& position) -> std::optional<Placement> {
+        auto const types = std::array<std::uint64_t, 6>{position.kings, position.queens, position.rooks, position.bishops, position.knights, position.pawns};
+        auto const occupied = position.white | position.black;
+        if ((position.white & position.black) != 0) return std::nullopt;
+
+        auto placement = Placement{{}, position.white_to_move != 0};
+        auto typed = std::uint64_t{0};
+        for (auto type = std::size_t{0}; type < types.size(); ++type) {
+            if ((types[type] & typed) != 0) return std::nullopt;
+            typed |= types[type];
+
+            for (auto square = 0; square < 64; ++square) {
+                if (((types[type] >> square) & 1) == 0) continue;
+                auto const is_white = ((position.white >> square) & 1) != 0;
+                placement.pieces.emplace_back(is_white ? static_cast<char>(std::toupper(PIECE_TYPES[type])) : PIECE_TYPES[type], square);
+            }
+        }
+        if (typed != occupied) return std::nullopt;
+        return placement;
+    }
+
+    // Unlike the parsing in PositionIndexer, this rejects malformed FEN strings
+    auto placement_of_FEN(std::string const& FEN_string) -> std::optional<Placement> {
+        auto placement = Placement{{}, true};
+        auto rank = 7;
+        auto file = 0;
+        auto i = std::size_t{0};
+        for (; i < FEN_string.size() and FEN_string[i] != ' '; ++i) {
+            auto const curr = FEN_string[i];
+            if (curr == '/') {
+                if (file != 8 or rank == 0) return std::nullopt;
+                --rank;
+                file = 0;
+            } else if ('1' <= curr and curr <= '8') {
+                file += curr - '0';
+            } else if (PIECE_TYPES.find(static_cast<char>(std::tolower(curr))) != std::string_view::npos and file < 8) {
+                placement.pieces.emplace_back(curr, rank * 8 + file);
+                ++file;
+            } else {
+                return std::nullopt;
+            }
+            if (file > 8) return std::nullopt;
+        }
+        if (file != 8 or rank != 0) return std::nullopt;
+
+        placement.isWhiteTurn = i + 1 >= FEN_string.size() or FEN_string[i + 1] != 'b';
+        return placement;
+    }
+
+    auto placement_of_board(chess::Board const& board) -> Placement {
+        auto placement = Placement{{}, board.sideToMove() == chess::Color::WHITE};
+        auto occupied = board.occ();
+        while (occupied.count()) {
+            auto const sq = chess::Square(occupied.pop());
+            placement.pieces.emplace_back(static_cast<std::string>(board.at(sq))[0], sq.index());
+        }
+        return placement;
+    }
+
+    auto board_of_placement(Placement const& placement) -> chess::Board {
+        auto squares = std::array<char, 64>{};
+        for (auto const& [piece, square] : placement.pieces) {
+            squares[static_cast<std::size_t>(square)] = piece;
+        }
+
+        auto FEN_string = std::string{};
+        for (auto rank = 7; rank >= 0; --rank) {
+            auto empty = 0;
+            for (auto file = 0; file < 8; ++file) {
+                auto const piece = squares[static_cast<std::size_t>(rank * 8 + file)];
+                if (piece == 0) {
+                    ++empty;
+                    continue;
+                }
+                if (empty > 0) FEN_string.push_back(static_cast<char>('0' + empty));
+                FEN_string.push_back(piece);
+                empty = 0;
+            }
+            if (empty > 0) FEN_string.push_back(static_cast<char>('0' + empty));
+            if (rank > 0) FEN_string.push_back('/');
+        }
+        FEN_string.append(placement.isWhiteTurn ? " w - - 0 1" : " b - - 0 1");
+        return chess::Board(FEN_string);
+    }
+
+    auto signature_of_placement(Placement const& placement) -> std::string {
+        auto pieces = std::vector<char>{};
+        for (auto const& [piece, square] : placement.pieces) {
+            pieces.push_back(piece);
+        }
+        return tablebase::signature_for_pieces(pieces);
+    }
+
+    auto colour_flipped_placement(Placement const& placement) -> Placement {
+        auto flipped = Placement{{}, not placement.isWhiteTurn};
+        for (auto const& [piece, square] : placement.pieces) {
+            flipped.pieces.emplace_back(flipped_colour(piece), square ^ 56);
+        }
+        return flipped;
+    }
+
+    auto depth_to_mate_of_placement(tbprobe_tablebase const& tablebase, Placement const& placement) -> int {
+        auto const iter = tablebase.tables.find(signature_of_placement(placement));
+        if (iter == tablebase.tables.end()) return TBPROBE_UNKNOWN;
+
+        auto const& loaded_table = iter->second;
+        auto const index = loaded_table.indexer.index_of_placement(placement.pieces, placement.isWhiteTurn);
+        if (not index) return TBPROBE_UNKNOWN;
+
+        if (not loaded_table.table->stores_index(*index)) {
+            auto board = board_of_placement(placement);
+            // unknown successors are negative, so white skips them and black escapes through them
+            return tablebase::resolve_with_successors(board, loaded_table.table->max_depth_to_mate(), [&tablebase](chess::Board const& successor) {
+                return depth_to_mate_of_placement(tablebase, placement_of_board(successor));
+            });
+        }
+        return tablebase::depth_to_mate_for_entry(loaded_table.table->entry_in_encoded_blocks(loaded_table.encoded_blocks, *index));
+    }
+
+    auto wdl_of_placement(tbprobe_tablebase const& tablebase, Placement const& placement) -> int {
+        auto const signature = signature_of_placement(placement);
+        auto const bitbase = tablebase.bitbases.find(signature);
+        if (bitbase != tablebase.bitbases.end()) {
+            auto const index = bitbase->second.indexer.index_of_placement(placement.pieces, placement.isWhiteTurn);
+            if (not index) return TBPROBE_UNKNOWN;
+            return static_cast<int>(bitbase->second.bitbase.at(*index));
+        }
+
+        auto const depth_to_mate = depth_to_mate_of_placement(tablebase, placement);
+        if (depth_to_mate >= 0) return TBPROBE_WIN;
+
+        auto const colour_flipped_depth_to_mate = depth_to_mate_of_placement(tablebase, colour_flipped_placement(placement));
+        if (colour_flipped_depth_to_mate >= 0) return TBPROBE_LOSS;
+        if (depth_to_mate == TBPROBE_UNKNOWN or colour_flipped_depth_to_mate == TBPROBE_UNKNOWN) return TBPROBE_UNKNOWN;
+
+        // neither table marks positions where the player who just moved is in check, as bitbases do
+        auto const board = board_of_placement(placement);
+        return board.isAttacked(board.kingSq(~board.sideToMove()), board.sideToMove()) ? TBPROBE_ILLEGAL : TBPROBE_DRAW;
+    }
+
+    auto best_moves_of_placement(tbprobe_tablebase const& tablebase, Placement const& placement, tbprobe_move* moves, int const max_moves) -> int {
+        auto const depth_to_mate = depth_to_mate_of_placement(tablebase, placement);
+        if (depth_to_mate < 0) return depth_to_mate == TBPROBE_UNKNOWN ? TBPROBE_UNKNOWN : 0;
+
+        auto board = board_of_placement(placement);
+        auto movelist = chess::Movelist();
+        chess::movegen::legalmoves(movelist, board);
+
+        auto num_moves = 0;
+        for (auto const curr_move : movelist) {
+            board.makeMove(curr_move);
+            auto const successor_depth_to_mate = depth_to_mate_of_placement(tablebase, placement_of_board(board));
+            board.unmakeMove(curr_move);
+            if (successor_depth_to_mate != depth_to_mate - 1) continue;
+
+            if (num_moves < max_moves) {
+                auto& move = moves[num_moves];
+                move = tbprobe_move{};
+                move.from = curr_move.from().index();
+                move.to = curr_move.to().index();
+                if (curr_move.typeOf() == chess::Move::PROMOTION) {
+                    move.promotion = static_cast<std::string>(curr_move.promotionType())[0];
+                }
+                auto const uci = chess::uci::moveToUci(curr_move);
+                std::strncpy(move.uci, uci.c_str(), sizeof(move.uci) - 1);
+            }
+            ++num_moves;
+        }
+        return num_moves;
+    }
+
+    // Exceptions must not escape through the C interface
+    template <typename Probe>
+    auto probe_safely(tbprobe_tablebase const* tablebase, std::optional<Placement> const& placement, Probe const& probe) -> int {
+        if (tablebase == nullptr or not placement) return TBPROBE_UNKNOWN;
+        try {
+            return probe(*tablebase, *placement);
+        } catch (...) {
+            return TBPROBE_UNKNOWN;
+        }
+    }
+
+    auto placement_of_position_pointer(tbprobe_position const* position) -> std::optional<Placement> {
+        if (position == nullptr) return std::nullopt;
+        return placement_of_position(*position);
+    }
+
+    auto placement_of_FEN_pointer(char const* FEN_string) -> std::optional<Placement> {
+        if (FEN_string == nullptr) return std::nullopt;
+        return placement_of_FEN(FEN_string);
+    }
+
+    auto write_error(char* error, std::size_t const error_size, std::string const& message) -> void {
+        if (error == nullptr or error_size == 0) return;
+        auto const length = std::min(message.size(), error_size - 1);
+        std::memcpy(error, message.data(), length);
+        error[length] = '\0';
+    }
+}
+
+
+extern "C" {
+    tbprobe_tablebase* tbprobe_open(char const* directory, char* error, std::size_t error_size) {
+        return tbprobe_open_with_options(directory, nullptr, error, error_size);
+    }
+
+    tbprobe_tablebase* tbprobe_open_with_options(char const* directory, tbprobe_options const* options, char* error, std::size_t error_size) {
+        try {
+            if (directory == nullptr) {
+                throw std::runtime_error("No directory given");
+            }
+
+            auto memory = tablebase::TableMemory{};
+            if (options != nullptr) {
+                if (options->huge_pages < TBPROBE_HUGE_PAGES_DEFAULT or options->huge_pages > TBPROBE_HUGE_PAGES_EXPLICIT
+                    or options->numa_placement < TBPROBE_NUMA_LOCAL or options->numa_placement > TBPROBE_NUMA_INTERLEAVE) {
+                    throw std::runtime_error("Unknown huge page or NUMA option");
+                }
+                memory.huge_pages = static_cast<tablebase::HugePages>(options->huge_pages);
+                memory.numa_placement = static_cast<tablebase::NumaPlacement>(options->numa_placement);
+            }
+
+            auto tablebase = std::make_unique<tbprobe_tablebase>();
+            for (auto const& file : std::filesystem::directory_iterator(directory)) {
+                if (file.path().extension() == tablebase::COMPRESSED_TABLE_EXTENSION) {
+                    auto table = std::make_unique<tablebase::CompressedTable>(file.path().string());
+                    auto encoded_blocks = table->read_encoded_blocks(memory);
+                    auto signature = table->signature();
+                    tablebase->tables.emplace(signature, tbprobe_tablebase::LoadedTable{tablebase::PositionIndexer(signature), std::move(table), std::move(encoded_blocks)});
+                } else if (file.path().extension() == tablebase::WDL_BITBASE_EXTENSION) {
+                    auto bitbase = tablebase::read_wdl_bitbase(file.path().string(), memory);
+                    auto signature = bitbase.signature;
+                    tablebase->bitbases.emplace(signature, tbprobe_tablebase::LoadedBitbase{tablebase::PositionIndexer(signature), std::move(bitbase)});
+                }
+            }
+            return tablebase.release();
+        } catch (std::exception const& exception) {
+            write_error(error, error_size, exception.what());
+        } catch (...) {
+            write_error(error, error_size, "Unknown error");
+        }
+        return nullptr;
+    }
+
+    void tbprobe_close(tbprobe_tablebase* tablebase) {
+        delete tablebase;
+    }
+
+    int tbprobe_has_table(tbprobe_tablebase const* tablebase, char const* signature) {
+        return tablebase != nullptr and signature != nullptr and tablebase->tables.contains(signature);
+    }
+
+    int tbprobe_has_bitbase(tbprobe_tablebase const* tablebase, char const* signature) {
+        return tablebase != nullptr and signature != nullptr and tablebase->bitbases.contains(signature);
+    }
+
+    int tbprobe_wdl(tbprobe_tablebase const* tablebase, tbprobe_position const* position) {
+        return probe_safely(tablebase, placement_of_position_pointer(position), wdl_of_placement);
+    }
+
+    int tbprobe_wdl_fen(tbprobe_tablebase const* tablebase, char const* FEN_string) {
+        return probe_safely(tablebase, placement_of_FEN_pointer(FEN_string), wdl_of_placement);
+    }
+
+    int tbprobe_dtm(tbprobe_tablebase const* tablebase, tbprobe_position const* position) {
+        return probe_safely(tablebase, placement_of_position_pointer(position), depth_to_mate_of_placement);
+    }
+
+    int tbprobe_dtm_fen(tbprobe_tablebase const* tablebase, char const* FEN_string) {
+        return probe_safely(tablebase, placement_of_FEN_pointer(FEN_string), depth_to_mate_of_placement);
+    }
+
+    int tbprobe_best_moves(tbprobe_tablebase const* tablebase, tbprobe_position const* position, tbprobe_move* moves, int max_moves) {
+        return probe_safely(tablebase, placement_of_position_pointer(position), [&](tbprobe_tablebase const& loaded, Placement const& placement) {
+            return best_moves_of_placement(loaded, placement, moves, moves == nullptr ? 0 : max_moves);
+        });
+    }
+
+    int tbprobe_best_moves_fen(tbprobe_tablebase const* tablebase, char const* FEN_string, tbprobe_move* moves, int max_moves) {
+        return probe_safely(tablebase, placement_of_FEN_pointer(FEN_string), [&](tbprobe_tablebase const& loaded, Placement const& placement) {
+            return best_moves_of_placement(loaded, placement, moves, moves == nullptr ? 0 : max_moves);
+        });
+    }
+}
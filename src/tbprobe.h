@@ -0,0 +1,122 @@
+#ifndef COMP3821_PROJ_TBPROBE_HEADER
+#define COMP3821_PROJ_TBPROBE_HEADER
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A C interface for probing a directory of tables (as written by ./run_engine --compressed-output
+// and --wdl-output) from other languages in-process. It is built as its own shared library
+// (libtbprobe), which only contains the code for reading tables, not the generator.
+//
+// Every table is read into memory when the tablebase is opened: WDL bitbases as they are, and
+// compressed tables as their encoded blocks, which are decoded per probe. Probing never writes to
+// the tablebase, so any number of threads can probe the same tablebase at once without locking.
+// There is no global state, so separate tablebases can be opened and closed independently.
+//
+// Squares use chess-library numbering (a1 = 0, h8 = 63). As with the rest of our tablebase,
+// results are from the perspective of the white player, so forced wins for black are found
+// through the colour flipped signature (e.g. kKq for kKQ), which must also be in the directory.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Only the functions below are exported from the shared library
+#if defined(__GNUC__)
+#define TBPROBE_API __attribute__((visibility("default")))
+#else
+#define TBPROBE_API
+#endif
+
+typedef struct tbprobe_tablebase tbprobe_tablebase;
+
+// Results of tbprobe_wdl (and tbprobe_wdl_fen), matching tablebase::WDL
+#define TBPROBE_ILLEGAL 0
+#define TBPROBE_WIN 1
+#define TBPROBE_DRAW 2
+#define TBPROBE_LOSS 3
+
+// Returned by every probe when nothing is known about the position, i.e. the FEN string is
+// malformed, or the tables the probe needs are not in the directory
+#define TBPROBE_UNKNOWN (-2)
+// Returned by depth to mate probes for positions which are not forced wins for white
+#define TBPROBE_NOT_A_FORCED_WIN (-1)
+
+// More than the number of legal moves in any chess position
+#define TBPROBE_MAX_MOVES 256
+
+// A position given by bitboards (bit n set for square n), in the style of other tablebase probing
+// libraries. Castling and en passant are not supported by our tables.
+typedef struct tbprobe_position {
+    uint64_t white;
+    uint64_t black;
+    uint64_t kings;
+    uint64_t queens;
+    uint64_t rooks;
+    uint64_t bishops;
+    uint64_t knights;
+    uint64_t pawns;
+    int white_to_move;
+} tbprobe_position;
+
+typedef struct tbprobe_move {
+    int from;
+    int to;
+    // 'q', 'r', 'b' or 'n' for promotions, and 0 otherwise
+    char promotion;
+    // The move in UCI notation, e.g. "e7e8q"
+    char uci[6];
+} tbprobe_move;
+
+// Values of tbprobe_options, matching tablebase::HugePages and tablebase::NumaPlacement
+#define TBPROBE_HUGE_PAGES_DEFAULT 0
+#define TBPROBE_HUGE_PAGES_OFF 1
+#define TBPROBE_HUGE_PAGES_TRANSPARENT 2
+#define TBPROBE_HUGE_PAGES_EXPLICIT 3
+#define TBPROBE_NUMA_LOCAL 0
+#define TBPROBE_NUMA_INTERLEAVE 1
+
+// How the memory holding the tables is allocated (see table_memory.h). Huge pages cut the TLB
+// misses of random probes into large tables, and interleaving suits probing from threads spread
+// over several NUMA nodes.
+typedef struct tbprobe_options {
+    int huge_pages;
+    int numa_placement;
+} tbprobe_options;
+
+// Loads every table in the directory. Returns NULL if the directory or any table in it cannot be
+// read, writing the reason into error (if error_size is non-zero).
+TBPROBE_API tbprobe_tablebase* tbprobe_open(char const* directory, char* error, size_t error_size);
+// As above, where NULL options are the defaults
+TBPROBE_API tbprobe_tablebase* tbprobe_open_with_options(char const* directory, tbprobe_options const* options, char* error, size_t error_size);
+
+// Frees a tablebase, which must not be probed by any thread after (or during) this
+TBPROBE_API void tbprobe_close(tbprobe_tablebase* tablebase);
+
+// Whether a depth to mate table (or a WDL bitbase) was loaded for the signature, e.g. "kKQn"
+TBPROBE_API int tbprobe_has_table(tbprobe_tablebase const* tablebase, char const* signature);
+TBPROBE_API int tbprobe_has_bitbase(tbprobe_tablebase const* tablebase, char const* signature);
+
+// Win/draw/loss for white. Bitbases answer directly. Without a bitbase for the signature, the depth
+// to mate tables of the signature and its colour flip are used instead (both are needed to tell a
+// draw from a loss).
+TBPROBE_API int tbprobe_wdl(tbprobe_tablebase const* tablebase, tbprobe_position const* position);
+TBPROBE_API int tbprobe_wdl_fen(tbprobe_tablebase const* tablebase, char const* FEN_string);
+
+// The depth to mate in plies, or TBPROBE_NOT_A_FORCED_WIN. Positions of a player to move whose half
+// of the table was not stored are resolved by probing their successors.
+TBPROBE_API int tbprobe_dtm(tbprobe_tablebase const* tablebase, tbprobe_position const* position);
+TBPROBE_API int tbprobe_dtm_fen(tbprobe_tablebase const* tablebase, char const* FEN_string);
+
+// Writes every move keeping to an optimal line (see tablebase::optimal_moves) into moves, which
+// should have room for TBPROBE_MAX_MOVES moves, and returns how many there are (0 if the position
+// is not a forced win for white, or is checkmate). At most max_moves moves are written.
+TBPROBE_API int tbprobe_best_moves(tbprobe_tablebase const* tablebase, tbprobe_position const* position, tbprobe_move* moves, int max_moves);
+TBPROBE_API int tbprobe_best_moves_fen(tbprobe_tablebase const* tablebase, char const* FEN_string, tbprobe_move* moves, int max_moves);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // COMP3821_PROJ_TBPROBE_HEADER
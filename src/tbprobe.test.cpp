@@ -0,0 +1,174 @@
+#include "./position_index.h"
+#include "./bitbase_solver.h"
+#include "./compressed_tablebase.h"
+#include "./wdl_bitbase.h"
+#include "./optimal_line.h"
+#include "./tbprobe.h"
+#include <catch.hpp>
+#include <chess.hpp>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <atomic>
+
+namespace {
+    auto position_of_board(chess::Board const& board) -> tbprobe_position {
+        return tbprobe_position{
+            board.us(chess::Color::WHITE).getBits(),
+            board.us(chess::Color::BLACK).getBits(),
+            board.pieces(chess::PieceType::KING).getBits(),
+            board.pieces(chess::PieceType::QUEEN).getBits(),
+            board.pieces(chess::PieceType::ROOK).getBits(),
+            board.pieces(chess::PieceType::BISHOP).getBits(),
+            board.pieces(chess::PieceType::KNIGHT).getBits(),
+            board.pieces(chess::PieceType::PAWN).getBits(),
+            board.sideToMove() == chess::Color::WHITE
+        };
+    }
+}
+
+TEST_CASE("Probing tables through the C interface") {
+    auto const dense_tables = tablebase::solve_signatures_with_bitboards({"kK", "kKR", "kKr"}, 40);
+
+    auto const directory = std::filesystem::temp_directory_path() / "comp3821_tbprobe_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    for (auto const& [signature, table] : dense_tables) {
+        // only storing white to move for kKR makes black to move probes resolve through successors
+        auto const stored_sides = (signature == "kKR") ? tablebase::StoredSides::WHITE_TO_MOVE : tablebase::StoredSides::BOTH;
+        tablebase::write_compressed_table(table, (directory / (signature + tablebase::COMPRESSED_TABLE_EXTENSION)).string(), 256, stored_sides);
+    }
+    // kKr is left without a bitbase, so its WDL probes fall back to the depth to mate tables
+    auto const bitbase = tablebase::generate_wdl_bitbase("kKR", 40, &dense_tables.at("kKR"), &dense_tables.at("kKr"), true);
+    tablebase::write_wdl_bitbase(bitbase, (directory / ("kKR" + std::string{tablebase::WDL_BITBASE_EXTENSION})).string());
+
+    char error[256] = {};
+    auto* const probe = tbprobe_open(directory.string().c_str(), error, sizeof(error));
+    REQUIRE(probe != nullptr);
+
+    auto const indexer = tablebase::PositionIndexer("kKR");
+    auto const& table = dense_tables.at("kKR");
+
+    SECTION("Depth to mate probes agree with the dense table") {
+        for (auto index = std::uint64_t{0}; index < indexer.size(); index += 61) {
+            auto const FEN_string = indexer.FEN_at(index);
+            if (not FEN_string) continue;
+
+            auto const expected = tablebase::depth_to_mate_for_entry(table.entries[index]);
+            auto const board = chess::Board(*FEN_string);
+            auto const position = position_of_board(board);
+            REQUIRE(tbprobe_dtm_fen(probe, FEN_string->c_str()) == expected);
+            REQUIRE(tbprobe_dtm(probe, &position) == expected);
+            REQUIRE(tbprobe_wdl(probe, &position) == static_cast<int>(bitbase.at(index)));
+        }
+    }
+
+    SECTION("Best moves match the optimal moves of the dense tables") {
+        for (auto index = std::uint64_t{0}; index < indexer.size(); index += 997) {
+            auto const FEN_string = indexer.FEN_at(index);
+            if (not FEN_string) continue;
+
+            auto const board = chess::Board(*FEN_string);
+            auto const expected = tablebase::optimal_moves(board, dense_tables);
+            tbprobe_move moves[TBPROBE_MAX_MOVES];
+            auto const num_moves = tbprobe_best_moves_fen(probe, FEN_string->c_str(), moves, TBPROBE_MAX_MOVES);
+
+            REQUIRE(num_moves == static_cast<int>(expected.size()));
+            for (auto i = 0; i < num_moves; ++i) {
+                CHECK(moves[i].from == expected[static_cast<std::size_t>(i)].from().index());
+                CHECK(moves[i].to == expected[static_cast<std::size_t>(i)].to().index());
+                CHECK(moves[i].uci == chess::uci::moveToUci(expected[static_cast<std::size_t>(i)]));
+            }
+        }
+        // checkmate has no moves left to make
+        CHECK(tbprobe_best_moves_fen(probe, "3R1k2/8/5K2/8/8/8/8/8 b - - 0 1", nullptr, 0) == 0);
+    }
+
+    SECTION("WDL probes without a bitbase use both colours' tables") {
+        auto const FEN_string = std::string{"5k2/8/5K2/3R4/8/8/8/8 w - - 0 1"};
+        CHECK(tbprobe_wdl_fen(probe, FEN_string.c_str()) == TBPROBE_WIN);
+        CHECK(tbprobe_wdl_fen(probe, tablebase::colour_flipped_FEN(FEN_string).c_str()) == TBPROBE_LOSS);
+        CHECK(tbprobe_wdl_fen(probe, "8/8/8/8/3k4/8/1r6/K7 w - - 0 1") == TBPROBE_DRAW);
+        // white's king is in check while it is black's turn
+        CHECK(tbprobe_wdl_fen(probe, "8/8/8/8/3k4/8/8/K6r b - - 0 1") == TBPROBE_ILLEGAL);
+    }
+
+    SECTION("Malformed positions and unknown signatures") {
+        CHECK(tbprobe_has_table(probe, "kKR"));
+        CHECK(tbprobe_has_bitbase(probe, "kKR"));
+        CHECK(not tbprobe_has_bitbase(probe, "kKr"));
+        CHECK(not tbprobe_has_table(probe, "kKQ"));
+
+        CHECK(tbprobe_dtm_fen(probe, "5k2/8/5K2/3Q4/8/8/8/8 w - - 0 1") == TBPROBE_UNKNOWN);
+        CHECK(tbprobe_dtm_fen(probe, "5k2/8/5K2/3R4/8/8/8 w - - 0 1") == TBPROBE_UNKNOWN);
+        CHECK(tbprobe_dtm_fen(probe, "5k2/8/5K2/3R5/8/8/8/8 w - - 0 1") == TBPROBE_UNKNOWN);
+        CHECK(tbprobe_dtm_fen(probe, "5k2/8/5K2/3X4/8/8/8/8 w - - 0 1") == TBPROBE_UNKNOWN);
+        CHECK(tbprobe_dtm_fen(probe, nullptr) == TBPROBE_UNKNOWN);
+
+        auto position = position_of_board(chess::Board("5k2/8/5K2/3R4/8/8/8/8 w - - 0 1"));
+        position.queens = position.rooks;
+        CHECK(tbprobe_dtm(probe, &position) == TBPROBE_UNKNOWN);
+
+        CHECK(tbprobe_open((directory / "missing").string().c_str(), error, sizeof(error)) == nullptr);
+        CHECK(std::string{error}.size() > 0);
+
+        auto const bad_options = tbprobe_options{TBPROBE_HUGE_PAGES_EXPLICIT + 1, TBPROBE_NUMA_LOCAL};
+        CHECK(tbprobe_open_with_options(directory.string().c_str(), &bad_options, nullptr, 0) == nullptr);
+        auto const options = tbprobe_options{TBPROBE_HUGE_PAGES_TRANSPARENT, TBPROBE_NUMA_INTERLEAVE};
+        auto* const huge_page_probe = tbprobe_open_with_options(directory.string().c_str(), &options, nullptr, 0);
+        REQUIRE(huge_page_probe != nullptr);
+        CHECK(tbprobe_dtm_fen(huge_page_probe, "5k2/8/5K2/3R4/8/8/8/8 w - - 0 1") == 1);
+        tbprobe_close(huge_page_probe);
+    }
+
+    SECTION("Corrupt tables fail to open or probe as unknown") {
+        auto const corrupt_directory = std::filesystem::temp_directory_path() / "comp3821_tbprobe_corrupt_test";
+        std::filesystem::remove_all(corrupt_directory);
+        std::filesystem::create_directories(corrupt_directory);
+        auto const path = corrupt_directory / ("kK" + std::string{tablebase::COMPRESSED_TABLE_EXTENSION});
+
+        // kK is a single run of draws, so its one block ends with the run's length
+        tablebase::write_compressed_table(dense_tables.at("kK"), path.string(), static_cast<std::uint32_t>(dense_tables.at("kK").entries.size()));
+        auto const file_size = std::filesystem::file_size(path);
+        {
+            auto file = std::fstream(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(static_cast<std::streamoff>(file_size - 2));
+            file.write("\x80\x80", 2);
+        }
+        auto* const corrupt_probe = tbprobe_open(corrupt_directory.string().c_str(), error, sizeof(error));
+        REQUIRE(corrupt_probe != nullptr);
+        CHECK(tbprobe_dtm_fen(corrupt_probe, "8/8/8/4k3/8/8/8/4K3 w - - 0 1") == TBPROBE_UNKNOWN);
+        tbprobe_close(corrupt_probe);
+
+        // block offsets past the end of the file
+        std::filesystem::resize_file(path, file_size - 1);
+        CHECK(tbprobe_open(corrupt_directory.string().c_str(), error, sizeof(error)) == nullptr);
+        CHECK(std::string{error}.find("block offsets") != std::string::npos);
+
+        std::filesystem::remove_all(corrupt_directory);
+    }
+
+    SECTION("Concurrent probes") {
+        auto num_mismatches = std::atomic<int>{0};
+        auto threads = std::vector<std::thread>{};
+        for (auto thread = 0; thread < 4; ++thread) {
+            threads.emplace_back([&, thread]() {
+                for (auto index = static_cast<std::uint64_t>(thread); index < indexer.size(); index += 401) {
+                    auto const FEN_string = indexer.FEN_at(index);
+                    if (not FEN_string) continue;
+                    if (tbprobe_dtm_fen(probe, FEN_string->c_str()) != tablebase::depth_to_mate_for_entry(table.entries[index])) {
+                        ++num_mismatches;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        CHECK(num_mismatches == 0);
+    }
+
+    tbprobe_close(probe);
+    std::filesystem::remove_all(directory);
+}
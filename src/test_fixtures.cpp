@@ -0,0 +1,119 @@
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <fstream>
+#include <filesystem>
+#include <optional>
+#include <cstdint>
+#include "helper.h"
+#include "test_fixtures.h"
+
+namespace fixtures {
+    // Private functions and constants/magic numbers
+    namespace {
+        auto constexpr FIXTURE_MAGIC = std::uint64_t{0x3132'3833'5846'5458}; // "XTFX3821"
+        // Bounds on what a fixture may hold, so a corrupt fixture is regenerated instead of read
+        auto constexpr MAX_PLIES = std::uint64_t{1000};
+        auto constexpr MAX_FEN_LENGTH = std::uint64_t{128};
+
+        using Tablebase = std::vector<std::unordered_set<std::string>>;
+        using Arguments = std::tuple<int, int, std::vector<char>>;
+
+        auto fixture_path(Arguments const& arguments) -> std::filesystem::path {
+            auto const& [depth_to_mate_checked, max_pieces_present, starting_pieces] = arguments;
+            auto const pieces = starting_pieces.empty() ? std::string{"all"} : std::string{starting_pieces.begin(), starting_pieces.end()};
+            return std::filesystem::path(TEST_FIXTURE_DIRECTORY) / (std::string{GENERATOR_VERSION} + "_"
+                + std::to_string(depth_to_mate_checked) + "_" + std::to_string(max_pieces_present) + "_" + pieces + ".fixture");
+        }
+
+        auto write_integer(std::ofstream& file, std::uint64_t const value) -> void {
+            file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+        }
+
+        auto read_integer(std::ifstream& file) -> std::uint64_t {
+            auto value = std::uint64_t{0};
+            file.read(reinterpret_cast<char*>(&value), sizeof(value));
+            return value;
+        }
+
+        // The fixture is written to a temporary file which is then renamed, so an interrupted run
+        // never leaves a truncated fixture behind. Failures only mean the next run generates it again.
+        auto write_fixture(std::filesystem::path const& path, Tablebase const& tablebase) -> void {
+            auto error = std::error_code{};
+            std::filesystem::create_directories(path.parent_path(), error);
+
+            auto const temporary_path = std::filesystem::path(path.string() + ".tmp");
+            {
+                auto file = std::ofstream(temporary_path, std::ios::binary);
+                write_integer(file, FIXTURE_MAGIC);
+                write_integer(file, tablebase.size());
+                for (auto const& forced_wins : tablebase) {
+                    write_integer(file, forced_wins.size());
+                    for (auto const& FEN_string : forced_wins) {
+                        write_integer(file, FEN_string.size());
+                        file.write(FEN_string.data(), static_cast<std::streamsize>(FEN_string.size()));
+                    }
+                }
+                if (not file) return;
+            }
+            std::filesystem::rename(temporary_path, path, error);
+        }
+
+        auto read_fixture(std::filesystem::path const& path) -> std::optional<Tablebase> {
+            auto file = std::ifstream(path, std::ios::binary);
+            if (not file or read_integer(file) != FIXTURE_MAGIC) {
+                return std::nullopt;
+            }
+
+            auto const num_plies = read_integer(file);
+            if (num_plies > MAX_PLIES) {
+                return std::nullopt;
+            }
+
+            auto tablebase = Tablebase(num_plies);
+            for (auto& forced_wins : tablebase) {
+                auto const num_states = read_integer(file);
+                for (auto state = std::uint64_t{0}; state < num_states and file; ++state) {
+                    auto const length = read_integer(file);
+                    if (length > MAX_FEN_LENGTH) {
+                        return std::nullopt;
+                    }
+                    auto FEN_string = std::string(length, ' ');
+                    file.read(FEN_string.data(), static_cast<std::streamsize>(FEN_string.size()));
+                    forced_wins.emplace(std::move(FEN_string));
+                }
+            }
+
+            // anything left over or missing means the fixture is not one we wrote
+            if (not file or file.peek() != std::ifstream::traits_type::eof()) {
+                return std::nullopt;
+            }
+            return tablebase;
+        }
+    }
+
+
+    auto generated_tablebase(
+        int const depth_to_mate_checked,
+        int const max_pieces_present,
+        std::vector<char> const& starting_pieces
+    ) -> Tablebase const& {
+        static auto mutex = std::mutex{};
+        static auto tablebases = std::map<Arguments, Tablebase>{};
+
+        auto lock = std::unique_lock(mutex);
+        auto const arguments = Arguments{depth_to_mate_checked, max_pieces_present, starting_pieces};
+        auto const cached = tablebases.find(arguments);
+        if (cached != tablebases.end()) {
+            return cached->second;
+        }
+
+        auto const path = fixture_path(arguments);
+        auto tablebase = read_fixture(path);
+        if (not tablebase) {
+            tablebase = helper::definitive_generate_tablebase(depth_to_mate_checked, max_pieces_present, starting_pieces);
+            write_fixture(path, *tablebase);
+        }
+        return tablebases.emplace(arguments, std::move(*tablebase)).first->second;
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef COMP3821_PROJ_TEST_FIXTURES_HEADER
+#define COMP3821_PROJ_TEST_FIXTURES_HEADER
+
+#include <vector>
+#include <string>
+#include <unordered_set>
+
+namespace fixtures {
+    // The result of helper::definitive_generate_tablebase for the given arguments, shared by every
+    // test case which asks for the same tablebase. Each tablebase is generated at most once per
+    // run, and is also written to a binary fixture in the build directory (named after a hash of
+    // the generator's sources, so changing the generator regenerates it), which later runs load
+    // instead of generating it again.
+    auto generated_tablebase(
+        int const depth_to_mate_checked,
+        int const max_pieces_present,
+        std::vector<char> const& starting_pieces
+    ) -> std::vector<std::unordered_set<std::string>> const&;
+}
+
+
+#endif // COMP3821_PROJ_TEST_FIXTURES_HEADER
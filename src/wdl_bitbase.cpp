@@ -0,0 +1,216 @@
+#include <vector>
+#include <string>
+#include <array>
+#include <cctype>
+#include <stdexcept>
+#include <filesystem>
+#include <fstream>
+#include "wdl_bitbase.h"
+#include "king_tables.h"
+
+namespace tablebase {
+    // Private functions and constants/magic numbers
+    namespace {
+        auto const MAGIC = std::array<char, 4>{'W', 'D', 'L', '1'};
+        auto const FORMAT_VERSION = std::uint32_t{1};
+        auto const POSITIONS_PER_WORD = 32;
+
+        template <typename T>
+        auto write_value(std::ofstream& file, T const& value) -> void {
+            file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        auto read_value(std::ifstream& file) -> T {
+            auto value = T{};
+            file.read(reinterpret_cast<char*>(&value), sizeof(T));
+            return value;
+        }
+
+        // A placement is a legal position if no pieces overlap and the king of the player who just
+        // took a move is not in check
+        // Identical pieces are only indexed in ascending order of their squares (see PositionIndexer)
+        auto is_canonical_order(std::string const& signature, std::vector<int> const& squares) -> bool {
+            for (auto i = std::size_t{1}; i < squares.size(); ++i) {
+                if (signature[i] == signature[i - 1] and squares[i] < squares[i - 1]) return false;
+            }
+            return true;
+        }
+
+        auto is_legal_placement(std::string const& signature, std::vector<int> const& squares, bool const isWhiteTurn) -> bool {
+            auto occupied = std::uint64_t{0};
+            for (auto const square : squares) {
+                if ((occupied >> square) & 1) return false;
+                occupied |= std::uint64_t{1} << square;
+            }
+
+            auto const king_of_player_who_moved = isWhiteTurn ? 'k' : 'K';
+            auto king_square = 0;
+            for (auto i = std::size_t{0}; i < signature.size(); ++i) {
+                if (signature[i] == king_of_player_who_moved) king_square = squares[i];
+            }
+
+            for (auto i = std::size_t{0}; i < signature.size(); ++i) {
+                if ((std::isupper(signature[i]) != 0) != isWhiteTurn) continue;
+                if (attacks_king_square(signature[i], squares[i], king_square, occupied)) return false;
+            }
+            return true;
+        }
+    }
+
+
+    auto WDLBitbase::at(std::uint64_t const index) const -> WDL {
+        auto const shift = 2 * (index % POSITIONS_PER_WORD);
+        return static_cast<WDL>((words[index / POSITIONS_PER_WORD] >> shift) & 3);
+    }
+
+    auto WDLBitbase::set(std::uint64_t const index, WDL const value) -> void {
+        auto const shift = 2 * (index % POSITIONS_PER_WORD);
+        auto& word = words[index / POSITIONS_PER_WORD];
+        word = (word & ~(std::uint64_t{3} << shift)) | (static_cast<std::uint64_t>(value) << shift);
+    }
+
+    auto generate_wdl_bitbase(
+        std::string const& signature,
+        int const depth_to_mate_checked,
+        DenseTable const* table,
+        DenseTable const* colour_flipped_table,
+        bool const losses_resolved
+    ) -> WDLBitbase {
+        auto const indexer = PositionIndexer(signature);
+        auto const colour_flipped_indexer = PositionIndexer(colour_flipped_signature(signature));
+
+        auto bitbase = WDLBitbase{
+            indexer.signature(),
+            depth_to_mate_checked,
+            losses_resolved,
+            indexer.size(),
+            TableVector<std::uint64_t>((indexer.size() + POSITIONS_PER_WORD - 1) / POSITIONS_PER_WORD, 0)
+        };
+
+        for (auto index = std::uint64_t{0}; index < indexer.size(); ++index) {
+            // touching kings are ruled out before building the placement or its FEN string
+            auto const king_pair = indexer.king_pair_at(index);
+            if (not are_legal_king_squares(king_pair / 64, king_pair % 64)) continue;
+
+            auto const squares = indexer.squares_at(index);
+            auto const isWhiteTurn = indexer.is_white_turn_at(index);
+
+            // the squares are checked directly rather than through FEN_at, which would build a FEN
+            // string for every index (overlapping pieces are ruled out by is_legal_placement)
+            if (not is_canonical_order(indexer.signature(), squares)) continue;
+            if (not is_legal_placement(indexer.signature(), squares, isWhiteTurn)) continue;
+
+            if (table != nullptr and table->entries[index] != NOT_A_FORCED_WIN) {
+                bitbase.set(index, WDL::WIN);
+                continue;
+            }
+
+            if (colour_flipped_table != nullptr) {
+                auto colour_flipped_placement = std::vector<std::pair<char, int>>{};
+                for (auto i = std::size_t{0}; i < squares.size(); ++i) {
+                    auto const piece = indexer.signature()[i];
+                    colour_flipped_placement.emplace_back(
+                        static_cast<char>(std::isupper(piece) ? std::tolower(piece) : std::toupper(piece)),
+                        squares[i] ^ 56
+                    );
+                }
+
+                auto const colour_flipped_index = colour_flipped_indexer.index_of_placement(colour_flipped_placement, not isWhiteTurn);
+                if (colour_flipped_table->entries[*colour_flipped_index] != NOT_A_FORCED_WIN) {
+                    bitbase.set(index, WDL::LOSS);
+                    continue;
+                }
+            }
+
+            bitbase.set(index, WDL::DRAW);
+        }
+
+        return bitbase;
+    }
+
+    auto write_wdl_bitbase(WDLBitbase const& bitbase, std::string const& path) -> std::uint64_t {
+        auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+        if (not file) {
+            throw std::runtime_error("Unable to open " + path + " for writing");
+        }
+
+        file.write(MAGIC.data(), MAGIC.size());
+        write_value(file, FORMAT_VERSION);
+        write_value(file, static_cast<std::uint32_t>(bitbase.signature.size()));
+        file.write(bitbase.signature.data(), static_cast<std::streamsize>(bitbase.signature.size()));
+        write_value(file, static_cast<std::int32_t>(bitbase.max_depth_to_mate));
+        write_value(file, static_cast<std::uint8_t>(bitbase.losses_resolved));
+        write_value(file, bitbase.size);
+        file.write(reinterpret_cast<char const*>(bitbase.words.data()), static_cast<std::streamsize>(bitbase.words.size() * sizeof(std::uint64_t)));
+
+        if (not file) {
+            throw std::runtime_error("Failed while writing " + path);
+        }
+        return static_cast<std::uint64_t>(file.tellp());
+    }
+
+    auto read_wdl_bitbase(std::string const& path, TableMemory const memory) -> WDLBitbase {
+        auto file = std::ifstream(path, std::ios::binary);
+        if (not file) {
+            throw std::runtime_error("Unable to open WDL bitbase " + path);
+        }
+
+        auto magic = std::array<char, 4>{};
+        file.read(magic.data(), magic.size());
+        if (magic != MAGIC or read_value<std::uint32_t>(file) != FORMAT_VERSION) {
+            throw std::runtime_error(path + " is not a WDL bitbase supported by this version");
+        }
+
+        auto bitbase = WDLBitbase{};
+        bitbase.signature.resize(read_value<std::uint32_t>(file));
+        file.read(bitbase.signature.data(), static_cast<std::streamsize>(bitbase.signature.size()));
+        bitbase.max_depth_to_mate = read_value<std::int32_t>(file);
+        bitbase.losses_resolved = read_value<std::uint8_t>(file) != 0;
+        bitbase.size = read_value<std::uint64_t>(file);
+        bitbase.words = TableVector<std::uint64_t>((bitbase.size + POSITIONS_PER_WORD - 1) / POSITIONS_PER_WORD, 0, TableAllocator<std::uint64_t>(memory));
+        file.read(reinterpret_cast<char*>(bitbase.words.data()), static_cast<std::streamsize>(bitbase.words.size() * sizeof(std::uint64_t)));
+
+        if (not file) {
+            throw std::runtime_error(path + " is truncated");
+        }
+        return bitbase;
+    }
+
+
+    WDLTablebase::WDLTablebase(std::string const& directory) {
+        for (auto const& file : std::filesystem::directory_iterator(directory)) {
+            if (file.path().extension() != WDL_BITBASE_EXTENSION) continue;
+
+            auto bitbase = read_wdl_bitbase(file.path().string());
+            auto signature = bitbase.signature;
+            bitbases_.emplace(signature, LoadedBitbase{PositionIndexer(signature), std::move(bitbase)});
+        }
+    }
+
+    auto WDLTablebase::probe_wdl(std::string const& FEN_string) const -> std::optional<WDL> {
+        auto const iter = bitbases_.find(signature_of_FEN(FEN_string));
+        if (iter == bitbases_.end()) return std::nullopt;
+
+        auto const index = iter->second.indexer.index_of_FEN(FEN_string);
+        if (not index) return WDL::ILLEGAL;
+        return iter->second.bitbase.at(*index);
+    }
+
+    auto WDLTablebase::probe_wdl(chess::Board const& board) const -> std::optional<WDL> {
+        auto const iter = bitbases_.find(signature_of_board(board));
+        if (iter == bitbases_.end()) return std::nullopt;
+
+        auto const index = iter->second.indexer.index_of_board(board);
+        if (not index) return WDL::ILLEGAL;
+        return iter->second.bitbase.at(*index);
+    }
+
+    auto WDLTablebase::signatures() const -> std::vector<std::string> {
+        auto res = std::vector<std::string>{};
+        for (auto const& [signature, loaded_bitbase] : bitbases_) {
+            res.emplace_back(signature);
+        }
+        return res;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef COMP3821_PROJ_WDL_BITBASE_HEADER
+#define COMP3821_PROJ_WDL_BITBASE_HEADER
+
+#include <vector>
+#include <string>
+#include <map>
+#include <optional>
+#include <cstdint>
+#include <chess.hpp>
+#include "position_index.h"
+
+namespace tablebase {
+    // Win/draw/loss values are from the perspective of the white player, as with the rest of our
+    // tablebase. DRAW covers every legal position that neither player can force a checkmate from
+    // within the depth to mate checked during generation.
+    enum class WDL : std::uint8_t {
+        ILLEGAL = 0,
+        WIN = 1,
+        DRAW = 2,
+        LOSS = 3,
+    };
+
+    auto constexpr WDL_BITBASE_EXTENSION = ".wdl";
+
+    // 2 bits per position for a single signature, indexed the same way as its dense table
+    struct WDLBitbase {
+        std::string signature;
+        int max_depth_to_mate;
+        // false if the colour flipped signature was not generated, in which case positions that
+        // black can force a win from are stored as DRAW
+        bool losses_resolved;
+        std::uint64_t size;
+        TableVector<std::uint64_t> words;
+
+        auto at(std::uint64_t const index) const -> WDL;
+        auto set(std::uint64_t const index, WDL const value) -> void;
+    };
+
+    // Derives the bitbase for a signature from the dense tables of the signature and of its colour
+    // flipped signature (a forced win for white in the colour flipped position being a loss). Either
+    // table may be null, where a missing table has no forced wins.
+    auto generate_wdl_bitbase(
+        std::string const& signature,
+        int const depth_to_mate_checked,
+        DenseTable const* table,
+        DenseTable const* colour_flipped_table,
+        bool const losses_resolved
+    ) -> WDLBitbase;
+
+    // Returns the size of the written file in bytes
+    auto write_wdl_bitbase(WDLBitbase const& bitbase, std::string const& path) -> std::uint64_t;
+
+    // Throws std::runtime_error if the file is missing or is not a WDL bitbase
+    auto read_wdl_bitbase(std::string const& path, TableMemory const memory = default_table_memory()) -> WDLBitbase;
+
+    // Every bitbase found in a directory, held fully in memory so that probes never touch the disk.
+    // This is intended for probing during search, with depth to mate probes (see
+    // CompressedTablebase) left for the root position.
+    class WDLTablebase {
+    public:
+        explicit WDLTablebase(std::string const& directory);
+
+        // Returns std::nullopt for positions whose signature has no bitbase, so that positions the
+        // bitbases do not cover are never mistaken for illegal ones
+        auto probe_wdl(std::string const& FEN_string) const -> std::optional<WDL>;
+        auto probe_wdl(chess::Board const& board) const -> std::optional<WDL>;
+
+        auto signatures() const -> std::vector<std::string>;
+
+    private:
+        struct LoadedBitbase {
+            PositionIndexer indexer;
+            WDLBitbase bitbase;
+        };
+
+        std::map<std::string, LoadedBitbase> bitbases_;
+    };
+}
+
+
+#endif // COMP3821_PROJ_WDL_BITBASE_HEADER
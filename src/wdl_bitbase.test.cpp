@@ -0,0 +1,80 @@
+#include "./test_fixtures.h"
+#include "./position_index.h"
+#include "./wdl_bitbase.h"
+#include <catch.hpp>
+#include <chess.hpp>
+#include <filesystem>
+
+TEST_CASE("WDL bitbases for three piece endgames") {
+    auto const& tablebase = fixtures::generated_tablebase(5, 3, std::vector<char>{});
+    auto const dense_tables = tablebase::dense_tables_from_tablebase(tablebase, 5);
+
+    auto const directory = std::filesystem::temp_directory_path() / "comp3821_wdl_bitbase_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    for (auto const& signature : std::vector<std::string>{"kK", "kKQ", "kKq", "kKN"}) {
+        auto const table = dense_tables.find(signature);
+        auto const colour_flipped_table = dense_tables.find(tablebase::colour_flipped_signature(signature));
+        auto const bitbase = tablebase::generate_wdl_bitbase(
+            signature,
+            5,
+            (table == dense_tables.end()) ? nullptr : &table->second,
+            (colour_flipped_table == dense_tables.end()) ? nullptr : &colour_flipped_table->second,
+            true
+        );
+        tablebase::write_wdl_bitbase(bitbase, (directory / (signature + tablebase::WDL_BITBASE_EXTENSION)).string());
+    }
+
+    auto const wdl_tablebase = tablebase::WDLTablebase(directory.string());
+
+    SECTION("Every forced win in the tablebase is a win") {
+        for (auto const& forced_wins : tablebase) {
+            for (auto const& FEN_string : forced_wins) {
+                if (tablebase::signature_of_FEN(FEN_string) != "kKQ") continue;
+                REQUIRE(wdl_tablebase.probe_wdl(FEN_string) == tablebase::WDL::WIN);
+            }
+        }
+    }
+
+    SECTION("Forced wins for black are losses") {
+        auto const FEN_string = std::string{"4k3/Q7/5K2/8/8/8/8/8 w - - 0 1"};
+        CHECK(tablebase::colour_flipped_FEN(FEN_string) == "8/8/8/8/8/5k2/q7/4K3 b - - 0 1");
+        CHECK(wdl_tablebase.probe_wdl(chess::Board(tablebase::colour_flipped_FEN(FEN_string))) == tablebase::WDL::LOSS);
+    }
+
+    SECTION("Positions without forced wins are draws") {
+        CHECK(wdl_tablebase.probe_wdl("5k2/8/5K2/2N5/8/8/8/8 b - - 0 1") == tablebase::WDL::DRAW);
+        CHECK(wdl_tablebase.probe_wdl("8/8/8/3k4/8/8/8/4K3 w - - 0 1") == tablebase::WDL::DRAW);
+        // mate in 9, which is beyond the depth checked
+        CHECK(wdl_tablebase.probe_wdl("8/4k3/8/3Q4/8/5K2/8/8 w - - 0 1") == tablebase::WDL::DRAW);
+    }
+
+    SECTION("Illegal positions and unknown signatures") {
+        // the black king is in check while it is white's turn
+        CHECK(wdl_tablebase.probe_wdl("4k3/8/8/8/4Q3/8/8/4K3 w - - 0 1") == tablebase::WDL::ILLEGAL);
+        CHECK(wdl_tablebase.probe_wdl("8/8/8/3kK3/8/8/8/8 b - - 0 1") == tablebase::WDL::ILLEGAL);
+        // kKR has no bitbase, which is told apart from an illegal position
+        CHECK(not wdl_tablebase.probe_wdl("4k3/8/8/8/8/8/8/R3K3 w - - 0 1").has_value());
+        CHECK(not wdl_tablebase.probe_wdl(chess::Board("4k3/8/8/8/8/8/8/R3K3 w - - 0 1")).has_value());
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("WDL bitbases skip orderings of identical pieces without building FEN strings") {
+    auto const indexer = tablebase::PositionIndexer("kKRR");
+    auto const bitbase = tablebase::generate_wdl_bitbase("kKRR", 0, nullptr, nullptr, false);
+
+    // without tables every legal position is a draw, and a position is legal when it has a FEN
+    // string and the player who just moved is not in check
+    for (auto index = std::uint64_t{0}; index < indexer.size(); index += 997) {
+        auto const FEN_string = indexer.FEN_at(index);
+        auto is_legal = FEN_string.has_value();
+        if (is_legal) {
+            auto const board = chess::Board(*FEN_string);
+            is_legal = not board.isAttacked(board.kingSq(~board.sideToMove()), board.sideToMove());
+        }
+        REQUIRE(bitbase.at(index) == (is_legal ? tablebase::WDL::DRAW : tablebase::WDL::ILLEGAL));
+    }
+}